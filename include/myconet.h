@@ -19,6 +19,7 @@ typedef uint32_t MycoNet_ID_t;
 /**
  * @brief 错误码定义。
  */
+#define MN_INFO_UNCHANGED       (3)
 #define MN_INFO_CACHE_PULLED    (2)
 #define MN_INFO_PENDING         (1)
 #define MN_OK                   (0)
@@ -36,10 +37,23 @@ typedef uint32_t MycoNet_ID_t;
 #define MN_ERR_NOTINITIALIZED   (-12)
 #define MN_ERR_SIZE_MISMATCH    (-13)
 #define MN_ERR_NULL_POINTER     (-14)
+#define MN_ERR_STALE            (-15)
+
+#define MN_WAIT_FOREVER         (0xFFFFFFFFu)
 
 #define MN_CONFIG_USE_STATIC_C 0 
 #define MN_CONFIG_NODE_NAME_MAX_LEN 64
 #define MN_CONFIG_NOTIFY_SIZE_CHECK 1
+#define MN_CONFIG_RPC_SLOTS 256 // pending requests per instance, power of 2
+#define MN_CONFIG_POOL_CLASSES 32 // payload pool size classes per instance
+#define MN_CONFIG_POOL_TLS_DEPTH 8 // blocks cached per thread and class
+#define MN_CONFIG_POOL_SLAB_SIZE (64 * 1024)
+#define MN_CONFIG_REGISTRY_SHARDS 16 // node registry lock shards per instance, power of 2
+#define MN_CONFIG_CACHE_LINE 64 // destructive interference size of the target
+#define MN_CONFIG_REGION_CHUNK 256 // dirty tracking granularity of PublishRegion, bytes
+#define MN_CONFIG_PULL_MANY_RETRIES 8 // re-gathers of a consistent PullMany before MN_ERR_BUSY
+#define MN_CONFIG_FANOUT_THREADS 0 // parallel fan-out workers per instance, 0: one per core but the caller's
+#define MN_CONFIG_PARTITIONS 64 // default key partitions of a publisher, see keyed Publish
 #define MN_CONFIG_
 
 /**
@@ -50,6 +64,7 @@ typedef enum MycoNet_NodeConf {
     CONF_CACHED = 1 << 0,
     CONF_NOTIFY_SIZE_CHECK = 1 << 1,
     CONF_LATCHED = 1 << 2,
+    CONF_VARSIZE = 1 << 3, // with CONF_CACHED: size is a capacity, each sample keeps its own length
 } MycoNet_NodeFlag_t;
 
 /**
@@ -62,6 +77,8 @@ typedef enum MycoNet_EventCode {
     EVENT_NOTIFY      = 1 << 2,
     EVENT_PUBLISH_SIG = 1 << 3,
     EVENT_LATCHED     = 1 << 4,
+    EVENT_REQUEST     = 1 << 5,
+    EVENT_PUBLISH_REGION = 1 << 6,
 } MycoNet_EventCode_t;
 
 /**
@@ -78,6 +95,8 @@ typedef struct MycoNet_EventParam {
     MycoNet_ID_t recver;
     void *data_p;
     uint32_t size;
+    uint32_t corr_id; // EVENT_REQUEST only, pass back to reply
+    uint32_t offset;  // EVENT_PUBLISH_REGION only, where data_p lands in the cache
 } MycoNet_EventParam_t;
 
 typedef struct MycoNet_SmallEventParam {
@@ -92,6 +111,21 @@ typedef struct MycoNet_SmallEventParam {
 typedef void (*MycoNet_EventCb_t)(const MycoNet_EventParam_t *param);
 typedef void (*MycoNet_SmallEventCb_t)(const MycoNet_SmallEventParam_t *param);
 
+/**
+ * @brief 请求应答回调，status < 0 时 data_p 为 NULL。
+ */
+typedef void (*MycoNet_RespCb_t)(int status, const void *data_p, uint32_t size, void *user_data);
+
+/**
+ * @brief 实例上下文，对应 C++ 的 MycoNet::GetInst(name)；传 NULL 表示默认实例。
+ */
+typedef struct myconet_ctx myconet_ctx_t;
+
+/**
+ * @brief 节点句柄，由 myconet_node_open() 获得，省去每次调用的 ID 查找。
+ */
+typedef struct myconet_node myconet_node_t;
+
 /**
  * @brief 创建节点时使用的配置结构体。
  */
@@ -128,11 +162,58 @@ MN_API int myconet_publish(MycoNet_ID_t id, const void *data_p, size_t size);
 MN_API int myconet_pull_anon(const char *target_node_name, void *data_p, size_t size);  // anonymous pull
 MN_API int myconet_pull(MycoNet_ID_t id, const char *target_node_name, void *data_p, size_t size);
 MN_API int myconet_pull_id(MycoNet_ID_t id, MycoNet_ID_t target_node_id, void *data_p, size_t size);
+MN_API int myconet_pull_next(MycoNet_ID_t id, const char *target_node_name, void *data_p, size_t size, uint32_t timeout_ms);
+MN_API int myconet_pull_next_id(MycoNet_ID_t id, MycoNet_ID_t target_node_id, void *data_p, size_t size, uint32_t timeout_ms);
 MN_API int myconet_notify(MycoNet_ID_t id, const char *target_node_name, const void *data_p, size_t size);
 MN_API int myconet_notify_id(MycoNet_ID_t id, MycoNet_ID_t target_node_id, const void *data_p, size_t size);
+// resp_cb gets MN_ERR_TIMEOUT from the next request or reply after timeout_ms;
+// on an otherwise idle instance call myconet_expire_requests() to fire it
+MN_API int myconet_request(MycoNet_ID_t id, const char *target_node_name, const void *data_p, size_t size, MycoNet_RespCb_t resp_cb, void *user_data, uint32_t timeout_ms, uint32_t *corr_id);
+MN_API int myconet_request_wait(MycoNet_ID_t id, const char *target_node_name, const void *data_p, size_t size, void *resp_p, size_t resp_size, uint32_t timeout_ms);
+MN_API int myconet_reply(MycoNet_ID_t id, uint32_t corr_id, const void *data_p, size_t size);
+MN_API int myconet_expire_requests();
 MN_API int myconet_pub_num(MycoNet_ID_t id);
 MN_API int myconet_sub_num(MycoNet_ID_t id);
 
+// instance contexts, every default-instance function above has a ctx twin
+MN_API myconet_ctx_t *myconet_ctx_open(const char *name); // get or create instance `name`
+MN_API void myconet_ctx_close(myconet_ctx_t *ctx);        // drop the handle, the instance stays
+MN_API void myconet_ctx_deinit(myconet_ctx_t *ctx);       // unregister the instance
+MN_API int myconet_ctx_reserve_pool(myconet_ctx_t *ctx, size_t count);
+MN_API int myconet_ctx_node_num(myconet_ctx_t *ctx);
+MN_API int myconet_ctx_create_node(myconet_ctx_t *ctx, MycoNet_ID_t *id, const char *name, const MycoNet_NodeParam_t *conf);
+MN_API int myconet_ctx_remove_node_id(myconet_ctx_t *ctx, MycoNet_ID_t id);
+MN_API int myconet_ctx_remove_node_name(myconet_ctx_t *ctx, const char *name);
+MN_API int myconet_ctx_subscribe(myconet_ctx_t *ctx, MycoNet_ID_t id, const char *target_node_name);
+MN_API int myconet_ctx_unsubscribe(myconet_ctx_t *ctx, MycoNet_ID_t id, const char *target_node_name);
+MN_API int myconet_ctx_unsubscribe_id(myconet_ctx_t *ctx, MycoNet_ID_t id, MycoNet_ID_t target_node_id);
+MN_API int myconet_ctx_publish(myconet_ctx_t *ctx, MycoNet_ID_t id, const void *data_p, size_t size);
+MN_API int myconet_ctx_pull_anon(myconet_ctx_t *ctx, const char *target_node_name, void *data_p, size_t size);
+MN_API int myconet_ctx_pull(myconet_ctx_t *ctx, MycoNet_ID_t id, const char *target_node_name, void *data_p, size_t size);
+MN_API int myconet_ctx_pull_id(myconet_ctx_t *ctx, MycoNet_ID_t id, MycoNet_ID_t target_node_id, void *data_p, size_t size);
+MN_API int myconet_ctx_pull_next(myconet_ctx_t *ctx, MycoNet_ID_t id, const char *target_node_name, void *data_p, size_t size, uint32_t timeout_ms);
+MN_API int myconet_ctx_pull_next_id(myconet_ctx_t *ctx, MycoNet_ID_t id, MycoNet_ID_t target_node_id, void *data_p, size_t size, uint32_t timeout_ms);
+MN_API int myconet_ctx_notify(myconet_ctx_t *ctx, MycoNet_ID_t id, const char *target_node_name, const void *data_p, size_t size);
+MN_API int myconet_ctx_notify_id(myconet_ctx_t *ctx, MycoNet_ID_t id, MycoNet_ID_t target_node_id, const void *data_p, size_t size);
+MN_API int myconet_ctx_request(myconet_ctx_t *ctx, MycoNet_ID_t id, const char *target_node_name, const void *data_p, size_t size, MycoNet_RespCb_t resp_cb, void *user_data, uint32_t timeout_ms, uint32_t *corr_id);
+MN_API int myconet_ctx_request_wait(myconet_ctx_t *ctx, MycoNet_ID_t id, const char *target_node_name, const void *data_p, size_t size, void *resp_p, size_t resp_size, uint32_t timeout_ms);
+MN_API int myconet_ctx_reply(myconet_ctx_t *ctx, MycoNet_ID_t id, uint32_t corr_id, const void *data_p, size_t size);
+MN_API int myconet_ctx_expire_requests(myconet_ctx_t *ctx);
+MN_API int myconet_ctx_pub_num(myconet_ctx_t *ctx, MycoNet_ID_t id);
+MN_API int myconet_ctx_sub_num(myconet_ctx_t *ctx, MycoNet_ID_t id);
+
+// handle API, the handle keeps the node object and its instance alive until
+// closed; after myconet_deinit() it still works on the detached instance
+MN_API myconet_node_t *myconet_ctx_node_open(myconet_ctx_t *ctx, MycoNet_ID_t id);
+MN_API myconet_node_t *myconet_node_open(MycoNet_ID_t id);
+MN_API void myconet_node_close(myconet_node_t *node);
+MN_API MycoNet_ID_t myconet_node_id(const myconet_node_t *node);
+MN_API int myconet_node_publish(myconet_node_t *node, const void *data_p, size_t size);
+MN_API int myconet_node_pull(myconet_node_t *node, const char *target_node_name, void *data_p, size_t size);
+MN_API int myconet_node_pull_id(myconet_node_t *node, MycoNet_ID_t target_node_id, void *data_p, size_t size);
+MN_API int myconet_node_notify(myconet_node_t *node, const char *target_node_name, const void *data_p, size_t size);
+MN_API int myconet_node_notify_id(myconet_node_t *node, MycoNet_ID_t target_node_id, const void *data_p, size_t size);
+
 
 #ifdef __cplusplus
 } // extern "C"
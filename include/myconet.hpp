@@ -2,16 +2,21 @@
 #define MYCONET_CPP_H
 
 #include "myconet.h"
+#include "myconet_pool.hpp"
 #include <string>
 #include <map>
 #include <set>
 #include <memory>
 #include <mutex>
 #include <shared_mutex>
+#include <condition_variable>
 #include <list>
 #include <vector>
 #include <functional>
+#include <algorithm>
 #include <atomic>
+#include <array>
+#include <chrono>
 
 namespace MycoNets { 
 
@@ -23,6 +28,7 @@ namespace MycoNets {
     using SmallEventParam = MycoNet_SmallEventParam_t;
     using EventCb = MycoNet_EventCb_t;
     using EventCbFn = std::function<void (const EventParam*)>;
+    using RespCbFn = std::function<void (int status, const void *data_p, size_t size)>;
     // TODO: small event for publish signal
     // using SmallEventCb = MycoNet_SmallEventCb_t;
     // using SmallEventCbFn = std::function<void (const SmallEventParam*)>;
@@ -36,6 +42,77 @@ namespace MycoNets {
         EventCbFn event_cb;
         void *user_data;
         uint32_t notify_size;
+        // cache placement, see MsgPool::AllocPlaced
+        int numa_node = NUMA_ANY; // node index, NUMA_ANY or NUMA_PUBLISHER
+        bool huge_pages = false;
+        // CONF_CACHED without CONF_VARSIZE: keep the last `history` samples in one shared ring
+        uint32_t history = 0;
+        // From this many subscribers on, Publish splits the callbacks across the
+        // instance's fan-out workers (0: always serial; ignored on SINGLE instances).
+        // Without fanout_wait it returns before they ran, delivering from a copy.
+        uint32_t fanout_threshold = 0;
+        bool fanout_wait = true;
+        // keyed Publish: keys hash into this many partitions (0: MN_CONFIG_PARTITIONS)
+        uint32_t partitions = 0;
+    };
+
+    // one target of MycoNode::PullMany
+    struct PullItem {
+        NodeID target;
+        void *buf;
+        size_t size;
+        int status;   // out: what Pull would have returned
+        uint64_t seq; // out: sample taken, 0 for uncached targets
+    };
+
+    // how a consumer group picks the one member that gets a publish
+    enum class GroupPolicy { ROUND_ROBIN, LEAST_LOADED };
+
+    // Consumer group on a publisher. Copy-on-write like the subscriber list:
+    // a membership change makes a new version that carries the cursor over.
+    struct ConsumerGroup {
+        std::string name;
+        GroupPolicy policy;
+        std::vector<NodeID> members; // sorted
+        std::shared_ptr<std::atomic<uint32_t>> cursor; // where the next pick starts
+        std::unique_ptr<std::atomic<int>[]> load;      // callbacks in flight, per member
+        std::vector<uint32_t> owner; // keyed publishes: partition -> member index
+    };
+    using GroupList = std::vector<std::shared_ptr<const ConsumerGroup>>;
+
+    // Declarative content filter: the unsigned `width` byte field (1, 2, 4 or 8,
+    // host byte order) at `offset` is masked and compared with `value`.
+    // Samples too short to hold the field never match.
+    struct FilterRule {
+        enum Op : uint8_t { EQ, NE, LT, LE, GT, GE };
+        uint32_t offset;
+        uint8_t width;
+        Op op;
+        uint64_t value;
+        uint64_t mask = ~0ull;
+    };
+    using FilterFn = std::function<bool (const void *data_p, size_t size)>;
+
+    // what a subscription filters on, a rule, a predicate or both
+    struct SubFilter {
+        bool has_rule = false;
+        FilterRule rule = {};
+        FilterFn pred;
+    };
+
+    // Filters of a publisher's subscribers, struct-of-arrays and parallel to the
+    // subscriber list it was built for, so one pass checks every rule.
+    struct FilterTable {
+        std::vector<uint32_t> offset;
+        std::vector<uint8_t> width;  // 0: no rule
+        std::vector<uint8_t> accept; // compare outcomes that pass: 1 equal, 2 less, 4 greater
+        std::vector<uint64_t> mask;
+        std::vector<uint64_t> value;
+        std::vector<FilterFn> pred;  // empty where there is none
+        // Set bit i of `pass` ((n + 63) / 64 words) when subscriber i takes the
+        // sample: one pass over all the rules, then the predicates of those that
+        // passed. Returns how many take it.
+        size_t Match(const void *buf, size_t size, uint64_t *pass) const;
     };
 
     // forward declaration
@@ -44,121 +121,404 @@ namespace MycoNets {
 
     const NodeID INVALID_ID = -1;
 
+    // How an instance is driven, fixed when GetInst creates it. SINGLE means
+    // one thread makes every call, callbacks included: locks are skipped and
+    // the hot paths borrow nodes instead of taking references.
+    enum class Threading { SHARED, SINGLE };
+
+    // std::mutex / std::shared_mutex that do nothing once disabled
+    class OptMutex {
+    public:
+        void lock() { if (enabled) m.lock(); }
+        bool try_lock() { return enabled ? m.try_lock() : true; }
+        void unlock() { if (enabled) m.unlock(); }
+        bool enabled = true;
+    private:
+        std::mutex m;
+    };
+
+    class OptSharedMutex {
+    public:
+        void lock() { if (enabled) m.lock(); }
+        bool try_lock() { return enabled ? m.try_lock() : true; }
+        void unlock() { if (enabled) m.unlock(); }
+        void lock_shared() { if (enabled) m.lock_shared(); }
+        bool try_lock_shared() { return enabled ? m.try_lock_shared() : true; }
+        void unlock_shared() { if (enabled) m.unlock_shared(); }
+        bool enabled = true;
+    private:
+        std::shared_mutex m;
+    };
+
     class MycoNode
     {
     public:
         friend class MycoNet;
         std::string node_name;
     private:
-        NodeID id;
+        // Read-mostly descriptor: set up by the constructor, only id changes
+        // afterwards (on removal). Kept off the lines the mutable state below
+        // lives on, so readers taking state.lock never invalidate it. Read it
+        // through MyID(): removal stores INVALID_ID while others read it unlocked.
+        std::atomic<NodeID> id;
         NodeFlag conflags;
-        MycoNet &net;
-        EventCbFn event_cb;
         EventMask event_mask;
-        std::vector<uint8_t> cache;
-        mutable std::shared_mutex cache_lock;
+        bool check_notify_size;
+        bool using_cache;
+        bool trigger_latch;
+        bool varsize;       // CONF_VARSIZE: cache_size is the largest sample, cache.Size() the latest
+        bool huge_pages;
+        int numa_node;
+        uint32_t history_depth; // ring slots, 1 without history
+        uint32_t fanout_threshold; // 0: serial fan-out
+        bool fanout_wait;
+        uint32_t partitions;
         size_t cache_size;
         size_t notify_size;
+        MycoNet &net;
         void *user_data;
+        Buffer cache;
+        EventCbFn event_cb;
+
+        // written by every Pull (lock word) and Publish
+        struct alignas(MN_CONFIG_CACHE_LINE) CacheState {
+            mutable OptSharedMutex lock;
+            uint64_t seq = 0;    // bumped by every Publish
+            uint64_t full_seq = 0; // last whole-cache Publish
+            int64_t stamp_ns = 0; // steady clock of the latest sample
+            bool placed = true; // NUMA_PUBLISHER pages moved
+            bool lent = false;  // a move-Publish is still dispatching from the cache block
+            // PublishRegion only: seq that last wrote each MN_CONFIG_REGION_CHUNK
+            // of the cache, allocated on first use. A chunk is as new as
+            // max(full_seq, chunk_seq[i]).
+            std::vector<uint64_t> chunk_seq;
+            std::atomic<int> waiters{0};
+            std::condition_variable_any cv;
+        } state;
+
+        // written by this node's own PullNext calls only
+        struct alignas(MN_CONFIG_CACHE_LINE) PullState {
+            OptMutex lock;
+            std::map<NodeID, uint64_t> seen_seq; // target -> last state.seq taken
+        } pulled;
+
+        // pub/sub adjacency, written by Subscribe/Unsubscribe/RemoveNode only
+        struct alignas(MN_CONFIG_CACHE_LINE) LinkState {
+            OptMutex lock;
+            // sorted, copy-on-write: Publish walks a snapshot without holding the lock
+            std::shared_ptr<const std::vector<NodeID>> subscribers;
+            std::shared_ptr<const GroupList> groups; // copy-on-write as well
+            std::map<NodeID, SubFilter> filter_of;
+            std::shared_ptr<const FilterTable> filters; // built from filter_of, null when unfiltered
+            std::set<NodeID> publishers;
+        } links;
+
+        static_assert(sizeof(CacheState) % MN_CONFIG_CACHE_LINE == 0, "CacheState must fill whole cache lines");
+        static_assert(sizeof(PullState) % MN_CONFIG_CACHE_LINE == 0, "PullState must fill whole cache lines");
+        static_assert(sizeof(LinkState) % MN_CONFIG_CACHE_LINE == 0, "LinkState must fill whole cache lines");
 
-        bool check_notify_size;
-        bool using_cache;
-        bool trigger_latch;
-        
     public:
         MycoNode() = delete;
         ~MycoNode() = default;
-        inline NodeID MyID() {return id;}
+        inline NodeID MyID() const {return id.load(std::memory_order_acquire);}
         int Subscribe(std::string target_node_name);
+        // Join consumer group `group` on the target: each publish goes to one
+        // member of the group only. The first member fixes the policy.
+        // MN_ERR_EXIST when already subscribed to the target some other way.
+        int Subscribe(std::string target_node_name, std::string group,
+                      GroupPolicy policy = GroupPolicy::ROUND_ROBIN);
+        // Subscriptions that only get the publishes `rule` or `filter` let through.
+        // The rules of all a publisher's subscribers are checked in one pass into a
+        // per-thread bitmap before any callback runs or payload is copied; predicates
+        // run right after it, on the publishing thread. Subscribing to the target
+        // again replaces the filter.
+        int Subscribe(std::string target_node_name, const FilterRule &rule);
+        int Subscribe(std::string target_node_name, FilterFn filter);
         int Unsubscribe(std::string target_node_name);
         int Unsubscribe(NodeID target_node_id);
         int Publish(const void *buf, size_t size);
+        // Like Publish, but every consumer group hands the sample to the member
+        // owning `key`'s partition, so one key always lands on the same member.
+        // Partitions go to members by rendezvous hashing: a member joining or
+        // leaving only moves the partitions it gains or loses.
+        int Publish(const void *buf, size_t size, uint64_t key);
+        // Zero-copy publish: `buf` becomes the cache contents (and what subscribers
+        // see) instead of being copied. The buffer it replaces is handed back in
+        // *prev for reuse, or freed when prev is null. Nodes with history, and
+        // nodes without a cache, deliver from `buf` and hand it back unchanged.
+        // Subscribers read the new cache block in place, so until their callbacks
+        // return every other write to the node (Publish, PublishRegion, a
+        // Transaction) fails with MN_ERR_BUSY instead of tearing the sample.
+        int Publish(Buffer &&buf, Buffer *prev = nullptr);
+        // Overwrite `len` bytes of the cache at `offset`, as one new sample.
+        // Subscribers get EVENT_PUBLISH_REGION with just those bytes; fixed-size
+        // cached nodes without history only.
+        int PublishRegion(size_t offset, const void *buf, size_t len);
         // TODO: features for future
         // int Publish0(std::function<void (void * const cache_p, size_t cache_size)>); // only cache enabled
         // int PublishSignal(const void *buf, size_t size) = delete;
         int Pull(NodeID target_node_id, void *buf, size_t size);
         int Pull(std::string target_node_name, void *buf, size_t size);
+        // `size` is the room in buf, *len gets the sample length (also on
+        // MN_ERR_SIZE_MISMATCH, so a CONF_VARSIZE reader can retry with enough)
+        int Pull(NodeID target_node_id, void *buf, size_t size, size_t *len);
+        int Pull(std::string target_node_name, void *buf, size_t size, size_t *len);
+        // length of the target's latest sample
+        int PeekSize(NodeID target_node_id, size_t *len);
+        int PeekSize(std::string target_node_name, size_t *len);
+        // Zero-copy read: fn sees the latest sample in place, under the target's
+        // read lock, so it must be short and must not publish to that node.
+        int Pull0(NodeID target_node_id, const std::function<void (const void *data_p, size_t size)> &fn);
+        int Pull0(std::string target_node_name, const std::function<void (const void *data_p, size_t size)> &fn);
         static int PullAnon(std::string target_node_name, void *buf, size_t size);
+        static int PullAnon(MycoNet &net, std::string target_node_name, void *buf, size_t size);
+        // block until the target publishes a sample newer than the one this node last took;
+        // never waits on a Threading::SINGLE instance, MN_ERR_TIMEOUT there when none is
+        int PullNext(NodeID target_node_id, void *buf, size_t size, uint32_t timeout_ms = MN_WAIT_FOREVER);
+        int PullNext(std::string target_node_name, void *buf, size_t size, uint32_t timeout_ms = MN_WAIT_FOREVER);
+        // Copy the latest sample only if it is newer than *last_seq, then set
+        // *last_seq to it (a jump of more than one means samples were missed).
+        // MN_INFO_UNCHANGED: nothing new, buf untouched. MN_ERR_STALE: the sample
+        // is older than max_age_ms (0: any age). stamp_ns gets its steady clock time.
+        int PullIfNewer(NodeID target_node_id, uint64_t *last_seq, void *buf, size_t size,
+                        uint32_t max_age_ms = 0, int64_t *stamp_ns = nullptr);
+        int PullIfNewer(std::string target_node_name, uint64_t *last_seq, void *buf, size_t size,
+                        uint32_t max_age_ms = 0, int64_t *stamp_ns = nullptr);
+        // history ring access, sample seqs start at 1 and count every Publish
+        int PullAt(NodeID target_node_id, uint64_t seq, void *buf, size_t size);
+        int PullAt(std::string target_node_name, uint64_t seq, void *buf, size_t size);
+        // copy up to n samples from `from` on (from 0: the newest n), oldest first;
+        // `size` is per sample and buf must hold n of them
+        int PullRange(NodeID target_node_id, uint64_t from, uint32_t n, void *buf, size_t size,
+                      uint64_t *first_seq = nullptr, uint32_t *pulled = nullptr);
+        int PullRange(std::string target_node_name, uint64_t from, uint32_t n, void *buf, size_t size,
+                      uint64_t *first_seq = nullptr, uint32_t *pulled = nullptr);
+        // Pull every item in one call, registry lookups batched per shard.
+        // Returns MN_OK, or the first failing item's status. With `consistent`
+        // (cached targets only) all samples were current at one common instant:
+        // items that moved while gathering are re-read, up to
+        // MN_CONFIG_PULL_MANY_RETRIES times, then MN_ERR_BUSY.
+        int PullMany(PullItem *items, size_t n, bool consistent = false);
+        // copy `len` bytes of the target's cache from `offset`
+        int PullRegion(NodeID target_node_id, size_t offset, void *buf, size_t len);
+        int PullRegion(std::string target_node_name, size_t offset, void *buf, size_t len);
+        // Incremental sync of a full-size mirror in `buf`: copies only the chunks
+        // written after sample *since, then sets *since to the latest seq.
+        // MN_ERR_NODATA when nothing is newer.
+        int PullDirty(NodeID target_node_id, uint64_t *since, void *buf, size_t size);
+        int PullDirty(std::string target_node_name, uint64_t *since, void *buf, size_t size);
         int Notify(std::string target_node_name, const void *buf, size_t size);
         int Notify(NodeID target_node_id, const void *buf, size_t size);
+        // async request, resp_cb runs on the thread that replies (or expires) it.
+        // Overdue requests are expired by the next Request or Reply on the
+        // instance; with no such traffic, call MycoNet::ExpireRequests() to
+        // have timeout_ms fire on time.
+        int Request(std::string target_node_name, const void *buf, size_t size, RespCbFn resp_cb,
+                    uint32_t timeout_ms = MN_WAIT_FOREVER, uint32_t *corr_id = nullptr);
+        int Request(NodeID target_node_id, const void *buf, size_t size, RespCbFn resp_cb,
+                    uint32_t timeout_ms = MN_WAIT_FOREVER, uint32_t *corr_id = nullptr);
+        // blocking request, resp_size must match the reply size
+        int Request(std::string target_node_name, const void *buf, size_t size,
+                    void *resp, size_t resp_size, uint32_t timeout_ms);
+        int Reply(uint32_t corr_id, const void *buf, size_t size);
         // TODO: features for future
-        // int Pull0(std::string target_node_name, std::function<void (const void *data_p, uint32_t size)>, size_t size); 
-        // int Pull0(NodeID target_node_id, std::function<void (const void *data_p, uint32_t size)>, size_t size);
         // int Push(NodeID target_node_id, const void *buf, size_t size) = delete;
         // int Push(std::string target_node_name, const void *buf, size_t size) = delete;
         int SubNum();
         int PubNum();
+        // payload buffer from the instance pool, size 0 means this node's cache size
+        Buffer Loan(size_t size = 0);
 
     protected:
         MycoNode(std::string name, const NodeParam &param, MycoNet &net);
 
     private:
+        // ring slot of sample `seq` (slot 0 before the first publish), state.lock held
+        uint8_t *Slot(uint64_t seq) {
+            if (history_depth == 1 || seq == 0) return cache.Data();
+            return cache.Data() + ((seq - 1) % history_depth) * cache_size;
+        }
+        // a fixed node needs buffers of exactly cache_size, CONF_VARSIZE is checked under the lock
+        bool SizeOk(size_t size) const { return varsize || size == cache_size; }
+        // length of the latest sample, state.lock held
+        size_t Length() const { return varsize ? cache.Size() : cache_size; }
+        // copy sample `seq` into a buffer of `size` bytes, state.lock held
+        int CopyOut(uint64_t seq, void *buf, size_t size, size_t *len = nullptr);
+        // CONF_VARSIZE: make room for a `size` byte sample, state.lock held
+        int Grow(size_t size, bool keep);
+        uint64_t OldestSeq() const {
+            return state.seq >= history_depth ? state.seq - history_depth + 1 : 1;
+        }
+        std::shared_ptr<const std::vector<NodeID>> Subscribers(std::shared_ptr<const GroupList> *groups = nullptr,
+                                                               std::shared_ptr<const FilterTable> *filters = nullptr);
+        // write the next sample into the cache, state.lock held exclusively
+        int Store(const void *buf, size_t size);
+        int DoPublish(const void *buf, size_t size, const uint64_t *key);
+        void Dispatch(EventCode event, const void *buf, size_t size, uint32_t offset = 0,
+                      const uint64_t *key = nullptr);
+        // callbacks of subscribers [first, last), runs on fan-out workers too.
+        // With a filter bitmap, `first` is subscriber `pass_first` in it.
+        static void DispatchRange(MycoNet &net, NodeID sender, const NodeID *first, const NodeID *last,
+                                  EventCode event, const void *buf, size_t size, uint32_t offset,
+                                  const uint64_t *pass = nullptr, size_t pass_first = 0);
+        void DispatchParallel(std::shared_ptr<const std::vector<NodeID>> subscribers,
+                              EventCode event, const void *buf, size_t size, uint32_t offset,
+                              const uint64_t *pass);
+        // swap a pool-backed cache for a standalone copy, so the node may outlive the pool
+        void DetachCache();
+        int LinkSubscriber(NodeID sub_id, const SubFilter *filter = nullptr);
+        void UnlinkSubscriber(NodeID sub_id); // also leaves its group
+        // links.lock held
+        const ConsumerGroup *GroupOf(NodeID sub_id) const;
+        bool LeaveGroup(NodeID sub_id);
+        void RebuildFilters();
+        int Subscribe(std::string target_node_name, std::string group, GroupPolicy policy,
+                      std::shared_ptr<const SubFilter> filter);
+        // subscriber side of Subscribe, also run by NewNode for pending subscriptions
+        int Attach(MycoNode &target_node, const std::string &group, GroupPolicy policy,
+                   const SubFilter *filter = nullptr);
+        int JoinGroup(NodeID sub_id, const std::string &group, GroupPolicy policy);
+        // one member of every group, called after the plain subscribers
+        void DispatchGroups(const GroupList &groups, EventCode event, const void *buf, size_t size,
+                            uint32_t offset = 0, const uint64_t *key = nullptr);
+        bool WantsLatched(const MycoNode &target_node) const {
+            return target_node.trigger_latch && (event_mask & EVENT_LATCHED);
+        }
+        // latched samples copied out of the cache, so callbacks run with no lock held
+        struct LatchSnapshot {
+            Buffer data;
+            size_t length = 0; // per sample
+            uint32_t count = 0;
+        };
+        int SnapshotLatched(LatchSnapshot &snap);
+        void DeliverLatched(NodeID sender, const LatchSnapshot &snap);
         int Unsubscribe(const std::shared_ptr<MycoNode> &target_node);
-        int Pull(const std::shared_ptr<MycoNode> &target_node, void *buf, size_t size);
-        // int Pull0(const std::shared_ptr<MycoNode> &target_node, std::function<void (const void *data_p, uint32_t size)>, size_t size);
+        int Pull(MycoNode &target_node, void *buf, size_t size, size_t *len = nullptr);
+        int PullNext(MycoNode &target_node, void *buf, size_t size, uint32_t timeout_ms);
+        int PullIfNewer(MycoNode &target_node, uint64_t *last_seq, void *buf, size_t size,
+                        uint32_t max_age_ms, int64_t *stamp_ns);
+        int PullAt(MycoNode &target_node, uint64_t seq, void *buf, size_t size);
+        int PullRange(MycoNode &target_node, uint64_t from, uint32_t n, void *buf, size_t size,
+                      uint64_t *first_seq, uint32_t *pulled);
+        int PullRegion(MycoNode &target_node, size_t offset, void *buf, size_t len);
+        int PullDirty(MycoNode &target_node, uint64_t *since, void *buf, size_t size);
+        int PeekSize(MycoNode &target_node, size_t *len);
+        int Pull0(MycoNode &target_node, const std::function<void (const void *data_p, size_t size)> &fn);
         int Push(const std::shared_ptr<MycoNode> &target_node, const void *buf, size_t size) = delete;
-        int Notify(const std::shared_ptr<MycoNode> &target_node, const void *buf, size_t size);
+        int Notify(MycoNode &target_node, const void *buf, size_t size);
+        int Request(MycoNode &target_node, const void *buf, size_t size,
+                    RespCbFn resp_cb, uint32_t timeout_ms, uint32_t *corr_id);
 
     };
 
     struct PendingItem {
         NodeID node_id;
         std::string target_node_name;
+        std::string group; // empty for a plain subscription
+        GroupPolicy policy;
+        std::shared_ptr<const SubFilter> filter;
+    };
+
+    // One in-flight Request. `tag` is the only synchronization: whoever moves
+    // it from a corr_id to BUSY owns the slot until it stores it back.
+    struct RpcSlot {
+        static constexpr uint32_t FREE = 0;
+        static constexpr uint32_t BUSY = 1;
+        std::atomic<uint32_t> tag{FREE};
+        std::atomic<int64_t> deadline_ns{INT64_MAX}; // readable without owning the slot
+        uint32_t round = 0;
+        NodeID client = INVALID_ID;
+        NodeID server = INVALID_ID;
+        RespCbFn resp_cb;
     };
     
 
+    // also keeps the make_shared control block (refcounts) off the descriptor
+    static_assert(alignof(MycoNode) >= MN_CONFIG_CACHE_LINE, "MycoNode must be cache-line aligned");
+
     class MycoNet
     {
     public: 
         friend class MycoNode;
     private:
-        std::map<NodeID, std::shared_ptr<MycoNode>> nodes;
-        std::map<std::string, NodeID> nodes_map;
-        std::shared_mutex nodes_mutex;
-
-        std::list<PendingItem> pending_list;
-        std::mutex pending_list_mutex;
+        // The registry is split into shards by id and by name hash, so nodes that
+        // land in different shards are created, looked up and removed in parallel.
+        // Lock order: name shard, then id shard.
+        struct alignas(MN_CONFIG_CACHE_LINE) IdShard {
+            OptSharedMutex lock;
+            std::map<NodeID, std::shared_ptr<MycoNode>> nodes;
+        };
+        struct alignas(MN_CONFIG_CACHE_LINE) NameShard {
+            OptSharedMutex lock;
+            std::map<std::string, std::shared_ptr<MycoNode>> nodes;
+            std::list<PendingItem> pending; // subscriptions waiting for a name of this shard
+        };
+        static_assert((MN_CONFIG_REGISTRY_SHARDS & (MN_CONFIG_REGISTRY_SHARDS - 1)) == 0, "MN_CONFIG_REGISTRY_SHARDS must be a power of 2");
+        std::array<IdShard, MN_CONFIG_REGISTRY_SHARDS> id_shards;
+        std::array<NameShard, MN_CONFIG_REGISTRY_SHARDS> name_shards;
+        std::atomic<int> node_count;
 
         std::atomic<NodeID> next_id;
-        
-        // we think this is not a high-frequency operation
-        std::map<NodeID, std::set<NodeID>> sp_map; // subscriber -> publisher(s)
-        std::map<NodeID, std::set<NodeID>> ps_map; // publisher -> subscriber(s)
-        std::shared_mutex spps_lock;
+
+        static_assert((MN_CONFIG_RPC_SLOTS & (MN_CONFIG_RPC_SLOTS - 1)) == 0, "MN_CONFIG_RPC_SLOTS must be a power of 2");
+        std::array<RpcSlot, MN_CONFIG_RPC_SLOTS> rpc_slots;
+        std::atomic<uint32_t> rpc_cursor;
+        // no pending request is due before this, INT64_MAX when none has a timeout
+        std::atomic<int64_t> rpc_due_ns{INT64_MAX};
+
+        MsgPool pool; // queued payloads, loaned buffers, snapshots
+
+        const Threading threading;
+        // Threading::SINGLE only: while anything is borrowed, objects that would
+        // be freed under it (removed nodes, replaced subscriber lists) wait here
+        int borrows = 0;
+        std::vector<std::shared_ptr<const void>> retired;
+        class Borrow;
+        class NodeHold;
+
+        // worker threads for parallel fan-out, started on first need
+        class FanoutPool;
+        std::mutex fanout_lock;
+        std::unique_ptr<FanoutPool> fanout;
 
         static std::map<std::string, std::shared_ptr<MycoNet>> insts;
         static std::mutex insts_mutex;
+        // insts["default"], kept while it is registered so Inst() skips the lookup
+        static std::atomic<MycoNet *> default_inst;
 
     public:
-        MycoNet() : next_id(1){};
-        ~MycoNet() = default;
+        class Transaction;
+
+        explicit MycoNet(Threading threading = Threading::SHARED);
+        ~MycoNet();
         MycoNet(const MycoNet&) = delete;
         MycoNet& operator=(const MycoNet&) = delete;
 
         std::pair<NodeID, std::shared_ptr<MycoNode>> GetNode(std::string node_name) {
-            std::shared_lock<std::shared_mutex> lock(nodes_mutex);
-            auto it = nodes_map.find(node_name);
+            NameShard &shard = NameShardOf(node_name);
+            std::shared_lock<OptSharedMutex> lock(shard.lock);
+            auto it = shard.nodes.find(node_name);
             std::pair<NodeID, std::shared_ptr<MycoNode>> pair = {INVALID_ID, nullptr};
-            if (it != nodes_map.end()) {
-                NodeID node_id = it->second;
-                auto node_it = nodes.find(node_id);
-                if (node_it != nodes.end() && node_it->second->id != INVALID_ID) {
-                    pair.first = node_id;
-                    pair.second = node_it->second;
-                }
+            if (it != shard.nodes.end() && it->second->MyID() != INVALID_ID) {
+                pair.first = it->second->MyID();
+                pair.second = it->second;
             }
             return pair;
         }
         std::shared_ptr<MycoNode> GetNode(int node_id) {
-            std::shared_lock<std::shared_mutex> lock(nodes_mutex);
-            auto it = nodes.find(node_id);
-            return (it != nodes.end() && it->second->id != INVALID_ID) ? it->second : nullptr;
+            IdShard &shard = IdShardOf(node_id);
+            std::shared_lock<OptSharedMutex> lock(shard.lock);
+            auto it = shard.nodes.find(node_id);
+            return (it != shard.nodes.end() && it->second->MyID() != INVALID_ID) ? it->second : nullptr;
         }
 
-        static std::shared_ptr<MycoNet> GetInst(const std::string& name = "default");
+        // `threading` only applies when this call creates the instance
+        static std::shared_ptr<MycoNet> GetInst(const std::string& name = "default",
+                                                Threading threading = Threading::SHARED);
         static void DelInst(const std::string& name = "default");
         static MycoNet& Inst() {
-            return *GetInst("default");
+            MycoNet *net = default_inst.load(std::memory_order_acquire);
+            return net ? *net : *GetInst("default");
         }
         static inline MycoNet& Self() {
             return Inst();
@@ -166,9 +526,12 @@ namespace MycoNets {
 
         std::shared_ptr<MycoNode> NewNode(std::string node_name, const NodeParam &param);
         inline int NodeNum() {
-            std::shared_lock<std::shared_mutex> lock(nodes_mutex);
-            return nodes.size();
+            return node_count.load();
         }
+        Threading GetThreading() const { return threading; }
+        // start the parallel fan-out workers (0: MN_CONFIG_FANOUT_THREADS), before
+        // any node needs them; MN_ERR_INITIALIZED once they run
+        int StartFanout(unsigned threads = 0);
 
         static const char *StrErrCode(int errnum) 
         {
@@ -176,6 +539,7 @@ namespace MycoNets {
                 case MN_OK: return "Success";
                 case MN_INFO_PENDING: return "Pending";
                 case MN_INFO_CACHE_PULLED: return "Pulled from cache";
+                case MN_INFO_UNCHANGED: return "Unchanged";
                 case MN_ERR_FAIL: return "General failure";
                 case MN_ERR_TIMEOUT: return "Timeout";
                 case MN_ERR_NOMEM: return "No memory";
@@ -190,6 +554,7 @@ namespace MycoNets {
                 case MN_ERR_NOTINITIALIZED: return "Not initialized";
                 case MN_ERR_SIZE_MISMATCH: return "Size mismatch";
                 case MN_ERR_NULL_POINTER: return "Null pointer";
+                case MN_ERR_STALE: return "Data too old";
                 default: return "Unknown code";
             }
         }
@@ -198,20 +563,88 @@ namespace MycoNets {
         int RemoveNode(std::string node_name);
         int RemoveNode(NodeID node_id);
 
+        MsgPool &Pool() { return pool; }
+        // unique per instance, also across instances that reuse an address
+        uint64_t Serial() const { return pool.Serial(); }
+        // pre-fill the pool with `count` blocks for every registered node's sizes,
+        // so steady-state traffic never reaches malloc
+        int ReservePool(size_t count);
+
+        // drop a pending request without running its callback
+        int CancelRequest(uint32_t corr_id);
+        // fail every overdue request with MN_ERR_TIMEOUT, returns how many
+        int ExpireRequests();
+
         NodeID NodeExists(std::string node_name) {
-            std::shared_lock<std::shared_mutex> lock(nodes_mutex);
-            auto it = nodes_map.find(node_name);
-            if (it != nodes_map.end()) return it->second;
+            NameShard &shard = NameShardOf(node_name);
+            std::shared_lock<OptSharedMutex> lock(shard.lock);
+            auto it = shard.nodes.find(node_name);
+            if (it != shard.nodes.end()) return it->second->MyID();
             return INVALID_ID; // not found
         }
 
         bool NodeExists(int node_id) {
-            std::shared_lock<std::shared_mutex> lock(nodes_mutex);
-            return nodes.count(node_id) ? true : false;
+            IdShard &shard = IdShardOf(node_id);
+            std::shared_lock<OptSharedMutex> lock(shard.lock);
+            return shard.nodes.count(node_id) ? true : false;
+        }
+
+    private:
+        IdShard &IdShardOf(NodeID node_id) {
+            return id_shards[static_cast<uint32_t>(node_id) & (MN_CONFIG_REGISTRY_SHARDS - 1)];
         }
+        NameShard &NameShardOf(const std::string &node_name) {
+            return name_shards[std::hash<std::string>{}(node_name) & (MN_CONFIG_REGISTRY_SHARDS - 1)];
+        }
+
+        // drop `obj` now, or once nothing is borrowed any more
+        void Retire(std::shared_ptr<const void> obj) {
+            if (threading == Threading::SINGLE && borrows > 0) retired.push_back(std::move(obj));
+        }
+        NodeHold Lookup(NodeID node_id);
+        NodeHold Lookup(const std::string &node_name);
+        // holds[i] for items[i].target, each id shard locked once
+        void LookupMany(const PullItem *items, size_t n, std::vector<NodeHold> &holds);
+
+        uint32_t RpcOpen(NodeID client, NodeID server, RespCbFn resp_cb, uint32_t timeout_ms);
+        RpcSlot *RpcTake(uint32_t corr_id);
+        void RpcRelease(RpcSlot *slot);
+        void RpcWatch(int64_t deadline_ns);
+        // ExpireRequests once rpc_due_ns has passed, run by Request and Reply
+        void RpcPoll();
+        int RpcExpire(int64_t now);
 
     };
 
+    /**
+     * Publishes to several nodes that land together. Publish only stages a
+     * copy; Commit writes every staged cache under all their state locks at
+     * once, so Pull, PullMany and latched subscriptions see either none or
+     * all of them, then delivers the events in one pass over the union of
+     * subscribers. Dropping an uncommitted transaction discards it.
+     */
+    class MycoNet::Transaction {
+    public:
+        explicit Transaction(MycoNet &net) : net(net) {}
+        Transaction(const Transaction &) = delete;
+        Transaction &operator=(const Transaction &) = delete;
+
+        // stage a sample, a second one for the same node replaces the first
+        int Publish(const std::shared_ptr<MycoNode> &node, const void *buf, size_t size);
+        // MN_ERR_BUSY while a staged node is lent to a move-Publish, nothing applied
+        int Commit();
+        void Abort() { staged.clear(); }
+        size_t Size() const { return staged.size(); }
+
+    private:
+        struct Staged {
+            std::shared_ptr<MycoNode> node;
+            Buffer data;
+        };
+        MycoNet &net;
+        std::vector<Staged> staged;
+    };
+
 }
 
 
@@ -0,0 +1,557 @@
+#ifndef MYCONET_CO_HPP
+#define MYCONET_CO_HPP
+
+// Optional C++20 coroutine layer over MycoNode. Header only, the library
+// itself keeps building as C++17 and nothing else includes this file.
+
+#include "myconet.hpp"
+
+#if !defined(__cpp_impl_coroutine) || __cpp_impl_coroutine < 201902L
+#error "myconet_co.hpp requires C++20 coroutines (-std=c++20)"
+#endif
+
+#include <coroutine>
+#include <exception>
+#include <new>
+#include <set>
+#include <string.h>
+
+namespace MycoNets::co {
+
+    // Decides where a resumed coroutine continues. Empty means resume inline
+    // on the thread that delivered the event (publisher, replier, ...).
+    using Executor = std::function<void (std::coroutine_handle<>)>;
+
+    // ================================================================
+    // coroutine frame pool
+    // ================================================================
+
+    // Frames are recycled per size class, so a coroutine started in a loop
+    // only reaches the heap on its first run. Oversized frames bypass the pool.
+    class FramePool {
+    public:
+        static constexpr size_t MIN_CLASS = 256;
+        static constexpr size_t CLASS_COUNT = 6; // 256 .. 8K
+
+        constexpr FramePool() = default;
+
+        void *Alloc(size_t size) {
+            size_t cls = ClassOf(size);
+            if (cls < CLASS_COUNT) {
+                std::lock_guard<std::mutex> guard(lock);
+                if (Block *block = free_list[cls]) {
+                    free_list[cls] = block->next;
+                    return block;
+                }
+                heap_allocs++;
+                return ::operator new(MIN_CLASS << cls);
+            }
+            std::lock_guard<std::mutex> guard(lock);
+            heap_allocs++;
+            return ::operator new(size);
+        }
+
+        void Free(void *p, size_t size) {
+            size_t cls = ClassOf(size);
+            if (cls >= CLASS_COUNT) {
+                ::operator delete(p);
+                return;
+            }
+            std::lock_guard<std::mutex> guard(lock);
+            Block *block = static_cast<Block *>(p);
+            block->next = free_list[cls];
+            free_list[cls] = block;
+        }
+
+        size_t HeapAllocs() {
+            std::lock_guard<std::mutex> guard(lock);
+            return heap_allocs;
+        }
+
+    private:
+        struct Block { Block *next; };
+
+        static size_t ClassOf(size_t size) {
+            size_t cls = 0;
+            while (cls < CLASS_COUNT && (MIN_CLASS << cls) < size) cls++;
+            return cls;
+        }
+
+        std::mutex lock;
+        Block *free_list[CLASS_COUNT] = {};
+        size_t heap_allocs = 0;
+    };
+
+    // constant-initialized, safe under -fno-threadsafe-statics
+    inline FramePool frame_pool;
+
+    struct PooledFrame {
+        static void *operator new(size_t size) { return frame_pool.Alloc(size); }
+        static void operator delete(void *p, size_t size) { frame_pool.Free(p, size); }
+    };
+
+    // ================================================================
+    // Task<T>: lazily started, awaitable coroutine
+    // ================================================================
+
+    template <typename T>
+    class Task;
+
+    namespace detail {
+        struct FinalAwaiter {
+            bool await_ready() noexcept { return false; }
+            template <typename Promise>
+            std::coroutine_handle<> await_suspend(std::coroutine_handle<Promise> h) noexcept {
+                auto next = h.promise().continuation;
+                return next ? next : std::noop_coroutine();
+            }
+            void await_resume() noexcept {}
+        };
+
+        struct PromiseBase : PooledFrame {
+            std::coroutine_handle<> continuation;
+            std::suspend_always initial_suspend() noexcept { return {}; }
+            FinalAwaiter final_suspend() noexcept { return {}; }
+            void unhandled_exception() noexcept { std::terminate(); }
+        };
+    }
+
+    template <typename T>
+    class Task {
+    public:
+        struct promise_type : detail::PromiseBase {
+            T value{};
+            Task get_return_object() { return Task(std::coroutine_handle<promise_type>::from_promise(*this)); }
+            void return_value(T v) { value = std::move(v); }
+        };
+
+        Task(Task &&other) noexcept : handle(other.handle) { other.handle = nullptr; }
+        Task(const Task &) = delete;
+        ~Task() { if (handle) handle.destroy(); }
+
+        bool await_ready() const noexcept { return false; }
+        std::coroutine_handle<> await_suspend(std::coroutine_handle<> caller) noexcept {
+            handle.promise().continuation = caller;
+            return handle;
+        }
+        T await_resume() { return std::move(handle.promise().value); }
+
+    private:
+        explicit Task(std::coroutine_handle<promise_type> h) : handle(h) {}
+        std::coroutine_handle<promise_type> handle;
+    };
+
+    template <>
+    class Task<void> {
+    public:
+        struct promise_type : detail::PromiseBase {
+            Task get_return_object() { return Task(std::coroutine_handle<promise_type>::from_promise(*this)); }
+            void return_void() {}
+        };
+
+        Task(Task &&other) noexcept : handle(other.handle) { other.handle = nullptr; }
+        Task(const Task &) = delete;
+        ~Task() { if (handle) handle.destroy(); }
+
+        bool await_ready() const noexcept { return false; }
+        std::coroutine_handle<> await_suspend(std::coroutine_handle<> caller) noexcept {
+            handle.promise().continuation = caller;
+            return handle;
+        }
+        void await_resume() {}
+
+    private:
+        explicit Task(std::coroutine_handle<promise_type> h) : handle(h) {}
+        std::coroutine_handle<promise_type> handle;
+    };
+
+    namespace detail {
+        // fire-and-forget root frame, destroys itself when the task completes
+        struct Detached {
+            struct promise_type : PooledFrame {
+                Detached get_return_object() { return {}; }
+                std::suspend_never initial_suspend() noexcept { return {}; }
+                std::suspend_never final_suspend() noexcept { return {}; }
+                void return_void() {}
+                void unhandled_exception() noexcept { std::terminate(); }
+            };
+        };
+
+        inline Detached RunDetached(Task<void> task) { co_await task; }
+    }
+
+    // start a task that nobody awaits; it runs until its first suspension now
+    inline void Spawn(Task<void> task) { detail::RunDetached(std::move(task)); }
+
+    // ================================================================
+    // CoNode: a MycoNode whose events resume coroutines
+    // ================================================================
+
+    class CoNode;
+
+    // `co_await node.NextPublish(topic, buf, size)` -> MN_OK or error code.
+    // Destroying the coroutine while it waits takes the awaiter off the node.
+    class PublishAwaiter {
+    public:
+        ~PublishAwaiter();
+        PublishAwaiter(const PublishAwaiter &) = delete;
+        PublishAwaiter &operator=(const PublishAwaiter &) = delete;
+
+        bool await_ready() const noexcept { return status != MN_INFO_PENDING; }
+        bool await_suspend(std::coroutine_handle<> h);
+        int await_resume() const noexcept { return status; }
+
+    private:
+        friend class CoNode;
+        PublishAwaiter(CoNode &owner, NodeID publisher, void *buf, size_t size, int status) :
+            owner(owner), publisher(publisher), buf(buf), size(size), status(status) {}
+
+        CoNode &owner;
+        NodeID publisher;
+        void *buf;
+        size_t size;
+        int status;
+        std::coroutine_handle<> handle;
+        PublishAwaiter *next = nullptr;
+        bool waiting = false; // in owner.waiters, guarded by owner.lock
+    };
+
+    // `co_await node.Request(...)` -> MN_OK or error code, response copied to resp.
+    // Destroying the coroutine while it waits cancels the request.
+    class RequestAwaiter {
+    public:
+        ~RequestAwaiter();
+        RequestAwaiter(const RequestAwaiter &) = delete;
+        RequestAwaiter &operator=(const RequestAwaiter &) = delete;
+
+        bool await_ready() const noexcept { return false; }
+        bool await_suspend(std::coroutine_handle<> h);
+        int await_resume() const noexcept { return status; }
+
+    private:
+        friend class CoNode;
+        RequestAwaiter(CoNode &owner, std::string target, const void *req, size_t req_size,
+                       void *resp, size_t resp_size, uint32_t timeout_ms) :
+            owner(owner), target(std::move(target)), req(req), req_size(req_size),
+            resp(resp), resp_size(resp_size), timeout_ms(timeout_ms) {}
+
+        CoNode &owner;
+        std::string target;
+        const void *req;
+        size_t req_size;
+        void *resp;
+        size_t resp_size;
+        uint32_t timeout_ms;
+        int status = MN_OK;
+        uint32_t corr_id = 0;
+        std::atomic<bool> arrived{false}; // second of (suspend, reply) resumes
+        std::coroutine_handle<> handle;
+    };
+
+    // Buffered subscription, read with `co_await stream.Next(buf, size)`.
+    // Ring slots are taken from the instance pool once; when the ring is full
+    // the oldest sample is dropped.
+    class Stream {
+    public:
+        class NextAwaiter {
+        public:
+            ~NextAwaiter();
+            NextAwaiter(const NextAwaiter &) = delete;
+            NextAwaiter &operator=(const NextAwaiter &) = delete;
+
+            bool await_ready();
+            bool await_suspend(std::coroutine_handle<> h);
+            int await_resume() const noexcept { return status; }
+
+        private:
+            friend class Stream;
+            friend class CoNode;
+            NextAwaiter(Stream &stream, void *buf, size_t size) : stream(stream), buf(buf), size(size) {}
+            Stream &stream;
+            void *buf;
+            size_t size;
+            int status = MN_OK;
+            std::coroutine_handle<> handle;
+            NextAwaiter *next = nullptr;
+        };
+
+        ~Stream();
+        Stream(const Stream &) = delete;
+        Stream &operator=(const Stream &) = delete;
+
+        NextAwaiter Next(void *buf, size_t size) { return NextAwaiter(*this, buf, size); }
+        size_t Dropped() const { return dropped; }
+        NodeID Publisher() const { return publisher; }
+
+    private:
+        friend class CoNode;
+        Stream(CoNode &owner, NodeID publisher, size_t depth, size_t slot_size);
+        // both called with owner.lock held
+        NextAwaiter *Push(const void *data_p, size_t data_size); // returns a reader to resume
+        void Pop(NextAwaiter &r);
+
+        CoNode &owner;
+        NodeID publisher;
+        size_t depth;
+        size_t slot_size;
+        std::vector<Buffer> slots;
+        size_t head = 0;
+        size_t count = 0;
+        size_t dropped = 0;
+        NextAwaiter *reader = nullptr;
+        Stream *next = nullptr;
+    };
+
+    class CoNode {
+    public:
+        // param.event_cb still receives every event the coroutine layer does not consume
+        static std::unique_ptr<CoNode> Create(MycoNet &net, std::string name, NodeParam param,
+                                              Executor executor = {}) {
+            std::unique_ptr<CoNode> co_node(new CoNode(net, executor));
+            co_node->user_cb = std::move(param.event_cb);
+            co_node->user_mask = param.event_msk;
+            param.event_msk = (EventMask)(param.event_msk | EVENT_PUBLISH);
+            param.event_cb = [self = co_node.get()](const EventParam *p) { self->OnEvent(p); };
+            co_node->node = net.NewNode(name, param);
+            if (co_node->node == nullptr) return nullptr;
+            return co_node;
+        }
+
+        ~CoNode() {
+            if (node) net.RemoveNode(node->MyID());
+        }
+
+        MycoNode &Node() { return *node; }
+
+        PublishAwaiter NextPublish(std::string topic, void *buf, size_t size) {
+            if (buf == nullptr) return PublishAwaiter(*this, INVALID_ID, buf, size, MN_ERR_NULL_POINTER);
+            NodeID publisher = INVALID_ID;
+            int ret = Follow(topic, &publisher);
+            return PublishAwaiter(*this, publisher, buf, size, ret == MN_OK ? MN_INFO_PENDING : ret);
+        }
+
+        RequestAwaiter Request(std::string target, const void *req, size_t req_size,
+                               void *resp, size_t resp_size, uint32_t timeout_ms = MN_WAIT_FOREVER) {
+            return RequestAwaiter(*this, std::move(target), req, req_size, resp, resp_size, timeout_ms);
+        }
+
+        // slot_size is the largest sample the stream keeps
+        std::unique_ptr<Stream> Subscribe(std::string topic, size_t depth, size_t slot_size) {
+            NodeID publisher = INVALID_ID;
+            if (depth == 0 || Follow(topic, &publisher) != MN_OK) return nullptr;
+            std::unique_ptr<Stream> stream(new Stream(*this, publisher, depth, slot_size));
+            for (auto &slot : stream->slots) {
+                if (!slot) return nullptr;
+            }
+            std::lock_guard<std::mutex> guard(lock);
+            stream->next = streams;
+            streams = stream.get();
+            return stream;
+        }
+
+    private:
+        friend class PublishAwaiter;
+        friend class RequestAwaiter;
+        friend class Stream;
+
+        CoNode(MycoNet &net, Executor executor) : net(net), executor(std::move(executor)) {}
+
+        void Resume(std::coroutine_handle<> h) {
+            if (executor) executor(h);
+            else h.resume();
+        }
+
+        int Follow(const std::string &topic, NodeID *publisher) {
+            auto [pub_id, pub_node] = net.GetNode(topic);
+            if (pub_id == INVALID_ID) return MN_ERR_NOTFOUND;
+            *publisher = pub_id;
+            std::lock_guard<std::mutex> guard(follow_lock);
+            if (followed.count(pub_id)) return MN_OK;
+            int ret = node->Subscribe(topic);
+            if (ret != MN_OK) return ret;
+            followed.insert(pub_id);
+            return MN_OK;
+        }
+
+        void OnEvent(const EventParam *p) {
+            if (p->event != EVENT_PUBLISH) {
+                if (user_cb) user_cb(p);
+                return;
+            }
+
+            // collect under the lock, resume after it: a resumed coroutine may await again
+            PublishAwaiter *ready = nullptr;
+            Stream::NextAwaiter *readers = nullptr;
+            {
+                std::lock_guard<std::mutex> guard(lock);
+                for (PublishAwaiter **pp = &waiters; *pp;) {
+                    PublishAwaiter *w = *pp;
+                    if (w->publisher != p->sender) { pp = &w->next; continue; }
+                    *pp = w->next;
+                    w->waiting = false;
+                    if (p->size == w->size) memcpy(w->buf, p->data_p, p->size);
+                    w->status = (p->size == w->size) ? MN_OK : MN_ERR_SIZE_MISMATCH;
+                    w->next = ready;
+                    ready = w;
+                }
+                for (Stream *s = streams; s; s = s->next) {
+                    if (s->publisher != p->sender) continue;
+                    Stream::NextAwaiter *r = s->Push(p->data_p, p->size);
+                    if (r == nullptr) continue;
+                    r->next = readers;
+                    readers = r;
+                }
+            }
+            while (ready) {
+                PublishAwaiter *w = ready;
+                ready = w->next;
+                Resume(w->handle);
+            }
+            while (readers) {
+                Stream::NextAwaiter *r = readers;
+                readers = r->next;
+                Resume(r->handle);
+            }
+
+            if (user_cb && (p->event & user_mask)) user_cb(p);
+        }
+
+        MycoNet &net;
+        Executor executor;
+        EventCbFn user_cb;
+        EventMask user_mask = EVENT_NONE;
+        std::shared_ptr<MycoNode> node;
+
+        std::mutex lock; // waiters and streams
+        PublishAwaiter *waiters = nullptr;
+        Stream *streams = nullptr;
+
+        std::mutex follow_lock;
+        std::set<NodeID> followed;
+    };
+
+    inline bool PublishAwaiter::await_suspend(std::coroutine_handle<> h) {
+        handle = h;
+        std::lock_guard<std::mutex> guard(owner.lock);
+        next = owner.waiters;
+        owner.waiters = this;
+        waiting = true;
+        return true;
+    }
+
+    inline PublishAwaiter::~PublishAwaiter() {
+        if (!handle) return; // never suspended
+        std::lock_guard<std::mutex> guard(owner.lock);
+        if (!waiting) return;
+        for (PublishAwaiter **pp = &owner.waiters; *pp; pp = &(*pp)->next) {
+            if (*pp == this) {
+                *pp = next;
+                break;
+            }
+        }
+    }
+
+    inline bool RequestAwaiter::await_suspend(std::coroutine_handle<> h) {
+        handle = h;
+        auto on_resp = [this](int resp_status, const void *data_p, size_t data_size) {
+            if (resp_status >= 0) {
+                if (data_size == resp_size) memcpy(resp, data_p, data_size);
+                else resp_status = MN_ERR_SIZE_MISMATCH;
+            }
+            status = resp_status;
+            if (arrived.exchange(true)) owner.Resume(handle);
+        };
+        int ret = owner.node->Request(target, req, req_size, on_resp, timeout_ms, &corr_id);
+        if (ret != MN_OK) {
+            status = ret;
+            return false;
+        }
+        // replied synchronously inside Request: keep running on this thread
+        return !arrived.exchange(true);
+    }
+
+    inline RequestAwaiter::~RequestAwaiter() {
+        // a reply that already ran leaves corr_id stale, cancelling it is a no-op
+        if (handle) owner.net.CancelRequest(corr_id);
+    }
+
+    inline Stream::Stream(CoNode &owner, NodeID publisher, size_t depth, size_t slot_size) :
+        owner(owner), publisher(publisher), depth(depth), slot_size(slot_size) {
+        slots.reserve(depth);
+        for (size_t i = 0; i < depth; i++) slots.push_back(owner.net.Pool().Alloc(slot_size));
+    }
+
+    inline Stream::~Stream() {
+        std::lock_guard<std::mutex> guard(owner.lock);
+        for (Stream **pp = &owner.streams; *pp; pp = &(*pp)->next) {
+            if (*pp == this) {
+                *pp = next;
+                break;
+            }
+        }
+    }
+
+    inline Stream::NextAwaiter *Stream::Push(const void *data_p, size_t data_size) {
+        if (reader) {
+            NextAwaiter *r = reader;
+            reader = nullptr;
+            if (data_size == r->size) memcpy(r->buf, data_p, data_size);
+            r->status = (data_size == r->size) ? MN_OK : MN_ERR_SIZE_MISMATCH;
+            return r;
+        }
+        if (data_size > slot_size) {
+            dropped++;
+            return nullptr;
+        }
+        if (count == depth) {
+            head = (head + 1) % depth;
+            count--;
+            dropped++;
+        }
+        Buffer &slot = slots[(head + count) % depth];
+        memcpy(slot.Data(), data_p, data_size);
+        slot.Resize(data_size);
+        count++;
+        return nullptr;
+    }
+
+    inline void Stream::Pop(NextAwaiter &r) {
+        const Buffer &slot = slots[head];
+        size_t length = slot.Size();
+        if (length == r.size) memcpy(r.buf, slot.Data(), length);
+        r.status = (length == r.size) ? MN_OK : MN_ERR_SIZE_MISMATCH;
+        head = (head + 1) % depth;
+        count--;
+    }
+
+    inline bool Stream::NextAwaiter::await_ready() {
+        std::lock_guard<std::mutex> guard(stream.owner.lock);
+        if (stream.count == 0) return false;
+        stream.Pop(*this);
+        return true;
+    }
+
+    inline bool Stream::NextAwaiter::await_suspend(std::coroutine_handle<> h) {
+        handle = h;
+        std::lock_guard<std::mutex> guard(stream.owner.lock);
+        if (stream.reader) { // one reader per stream
+            status = MN_ERR_BUSY;
+            return false;
+        }
+        if (stream.count > 0) { // a sample slipped in after await_ready
+            stream.Pop(*this);
+            return false;
+        }
+        stream.reader = this;
+        return true;
+    }
+
+    inline Stream::NextAwaiter::~NextAwaiter() {
+        if (!handle) return; // never suspended
+        std::lock_guard<std::mutex> guard(stream.owner.lock);
+        if (stream.reader == this) stream.reader = nullptr;
+    }
+
+}
+
+#endif // MYCONET_CO_HPP
@@ -0,0 +1,166 @@
+#ifndef MYCONET_POOL_H
+#define MYCONET_POOL_H
+
+#include "myconet.h"
+#include <array>
+#include <atomic>
+#include <mutex>
+#include <vector>
+
+namespace MycoNets {
+
+    class MsgPool;
+
+    // NUMA placement requests for node caches
+    constexpr int NUMA_ANY = -1;       // first touch, wherever the allocating thread runs
+    constexpr int NUMA_PUBLISHER = -2; // migrate to the node of the first publishing thread
+
+    /**
+     * Move-only byte buffer handed out by a MsgPool. The block goes back to
+     * its pool when the buffer is destroyed or reset, so a buffer must not
+     * outlive the MycoNet instance it came from.
+     */
+    class Buffer {
+    public:
+        Buffer() = default;
+        Buffer(Buffer &&other) noexcept { Take(other); }
+        Buffer &operator=(Buffer &&other) noexcept {
+            if (this != &other) {
+                Reset();
+                Take(other);
+            }
+            return *this;
+        }
+        Buffer(const Buffer &) = delete;
+        Buffer &operator=(const Buffer &) = delete;
+        ~Buffer() { Reset(); }
+
+        uint8_t *Data() { return data; }
+        const uint8_t *Data() const { return data; }
+        size_t Size() const { return size; }
+        size_t Capacity() const { return capacity; }
+        explicit operator bool() const { return data != nullptr; }
+        // true when the block does not go back to a MsgPool, so it may outlive one
+        bool Standalone() const;
+
+        // change the valid length without reallocating
+        int Resize(size_t new_size) {
+            if (new_size > capacity) return MN_ERR_SIZE_MISMATCH;
+            size = new_size;
+            return MN_OK;
+        }
+        void Reset();
+
+    private:
+        friend class MsgPool;
+        void Take(Buffer &other) {
+            data = other.data;
+            size = other.size;
+            capacity = other.capacity;
+            pool = other.pool;
+            cls = other.cls;
+            other.data = nullptr;
+            other.size = other.capacity = 0;
+            other.pool = nullptr;
+        }
+
+        uint8_t *data = nullptr;
+        size_t size = 0;
+        size_t capacity = 0;
+        MsgPool *pool = nullptr;
+        uint8_t cls = 0;
+    };
+
+    struct PoolStats {
+        size_t block_size;
+        size_t total;      // blocks carved from slabs so far
+        size_t in_use;     // blocks currently held by Buffers
+        size_t high_water; // largest in_use ever seen
+    };
+
+    /**
+     * Size-class slab pool, one per MycoNet instance. Blocks come from
+     * MN_CONFIG_POOL_SLAB_SIZE slabs and are recycled through a central
+     * free list per class plus a small per-thread magazine, so only slab
+     * growth and oversized requests reach malloc.
+     */
+    class MsgPool {
+    public:
+        static constexpr uint8_t OVERSIZE = 0xFF; // plain aligned malloc
+        static constexpr uint8_t MAPPED = 0xFE;   // private mapping, see AllocPlaced
+        static constexpr uint8_t STANDALONE = MAPPED; // classes from here on skip the pool
+
+        MsgPool();
+        ~MsgPool();
+        MsgPool(const MsgPool &) = delete;
+        MsgPool &operator=(const MsgPool &) = delete;
+
+        // returns an empty Buffer when out of memory
+        Buffer Alloc(size_t size);
+        // Zero-filled, cache-line aligned buffer that does not depend on any pool
+        // staying alive. With a NUMA node or huge pages requested it is a private
+        // mapping (hugetlbfs first, then THP) bound to that node. Placement is best
+        // effort: the buffer is still returned if the kernel refuses it.
+        static Buffer AllocPlaced(size_t size, int numa_node, bool huge_pages);
+        // move a MAPPED buffer's pages to `numa_node`
+        static int BindNode(Buffer &buf, int numa_node);
+        // NUMA node of the calling thread's CPU, 0 when unknown
+        static int CurrentNumaNode();
+
+        // add an exact-fit class, typically a node's payload size
+        int AddClass(size_t block_size);
+        // make sure `count` blocks for `size` are free right now
+        int Reserve(size_t size, size_t count);
+
+        void Stats(std::vector<PoolStats> &out) const;
+        size_t HeapAllocs() const { return heap_allocs.load(std::memory_order_relaxed); }
+        uint64_t Serial() const { return serial; }
+
+    private:
+        friend class Buffer;
+        friend struct PoolMagazine;
+
+        struct SizeClass {
+            size_t block_size = 0;
+            std::mutex lock;
+            void *free_list = nullptr; // intrusive, first word of each block
+            std::vector<void *> slabs;
+            std::atomic<size_t> total{0};
+            std::atomic<size_t> in_use{0};
+            std::atomic<size_t> high_water{0};
+        };
+
+        int ClassFor(size_t size) const;
+        void *PopCentral(uint8_t cls);
+        void PushCentral(uint8_t cls, void *block);
+        int Grow(SizeClass &sc); // called with sc.lock held
+        static Buffer AllocHeap(size_t size);
+        void Free(uint8_t *data, uint8_t cls);
+        static void FreeStandalone(uint8_t *data, size_t capacity, uint8_t cls);
+
+        std::array<SizeClass, MN_CONFIG_POOL_CLASSES> classes;
+        std::atomic<uint32_t> class_num;
+        std::mutex class_lock; // serializes AddClass, readers go by class_num
+        std::atomic<size_t> heap_allocs;
+        const uint64_t serial;
+    };
+
+    inline bool Buffer::Standalone() const
+    {
+        return data == nullptr || cls >= MsgPool::STANDALONE;
+    }
+
+    inline void Buffer::Reset()
+    {
+        if (data) {
+            if (cls >= MsgPool::STANDALONE) MsgPool::FreeStandalone(data, capacity, cls);
+            else pool->Free(data, cls);
+        }
+        data = nullptr;
+        size = capacity = 0;
+        pool = nullptr;
+    }
+
+}
+
+#endif // MYCONET_POOL_H
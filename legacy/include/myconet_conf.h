@@ -1,6 +1,41 @@
 #ifndef MYCONET_CONF_H
 #define MYCONET_CONF_H
 
+/**
+ * Static allocation mode: node slots, subscriber arrays and node caches come
+ * from fixed pools sized below and the core never calls malloc. Running out
+ * of a pool is reported as MN_ERR_NOMEM.
+ */
+#ifndef MN_CONF_STATIC_ALLOC
+#define MN_CONF_STATIC_ALLOC 0
+#endif
 
+#if MN_CONF_STATIC_ALLOC
+
+// registered nodes, the dummy node included
+#ifndef MN_CONF_MAX_NODES
+#define MN_CONF_MAX_NODES 32
+#endif
+
+// subscribers of a node, and subscriptions of a node
+#ifndef MN_CONF_MAX_SUBS
+#define MN_CONF_MAX_SUBS 8
+#endif
+
+// subscriber arrays on top of the two every node holds, covers the
+// snapshots pinned by publishes running while a subscription changes
+#ifndef MN_CONF_SPARE_SUB_ARRAYS
+#define MN_CONF_SPARE_SUB_ARRAYS 8
+#endif
+
+// number of CONF_CACHED nodes and the largest cache they may use
+#ifndef MN_CONF_CACHE_BLOCKS
+#define MN_CONF_CACHE_BLOCKS 16
+#endif
+#ifndef MN_CONF_CACHE_BLOCK_SIZE
+#define MN_CONF_CACHE_BLOCK_SIZE 64
+#endif
+
+#endif /* MN_CONF_STATIC_ALLOC */
 
 #endif 
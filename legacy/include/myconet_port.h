@@ -4,6 +4,7 @@
 #include <myconet_conf.h>
 
 #include <pthread.h>
+#include <sched.h>
 #define Mem_alloc(size)   malloc(size)
 #define Mem_free(ptr)     free(ptr)
 #if MN_CONF_USE_LOCK
@@ -12,6 +13,7 @@
 #define Mutex_lock(m)     pthread_mutex_lock(m)
 #define Mutex_unlock(m)   pthread_mutex_unlock(m)
 #define Mutex_destroy(m)  pthread_mutex_destroy(m)
+#define Thread_yield()    sched_yield()
 
 #if 1
 #define Rwlock_t            pthread_rwlock_t
@@ -38,6 +40,7 @@
 #define Mutex_lock(m)     
 #define Mutex_unlock(m)   
 #define Mutex_destroy(m)  
+#define Thread_yield()    
 
 #define Rwlock_t            
 #define Rwlock_init(m)      
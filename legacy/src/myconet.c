@@ -2,10 +2,12 @@
 #include <stdlib.h>
 #include <string.h>
 #include <stdbool.h>
+#include <stddef.h>
 #include <stdatomic.h>
 #include <myconet.h>
 #include <myconet_conf.h>
 #include <myconet_port.h>
+#include "simap.h"
 
 //==============================================================================
 // Error Codes
@@ -33,24 +35,30 @@
 //==============================================================================
 
 
+/* immutable once published, edits copy the array and swap the pointer. The
+ * one exception is a deinit short of memory, which clears its entry in place.
+ * Every entry pins its node until the array is freed, see node_wait_unpinned. */
 typedef \
-struct ll_node {
-    struct ll_node *next;
-    MycoNode_t     *data;
-} ll_node_t;
-
-typedef \
-struct ll_list {
-    ll_node_t *head;
-    ll_node_t *tail;
-    size_t     size;
-} ll_list_t;
+struct node_vec {
+    atomic_uint  refs;
+    uint32_t     size;
+    _Atomic(MycoNode_t *) data[];
+} node_vec_t;
+
+/* subscriber arrays the publishes on this thread are walking, innermost first */
+struct publish_frame {
+    const node_vec_t     *subs;
+    struct publish_frame *prev;
+};
 
 struct DataNodePriv {
     atomic_bool  is_inited;
     atomic_bool  is_registered;
-    ll_list_t    subscribers;
-    ll_list_t    subscriptions;
+    uint32_t     name_hash;     // simap_hash(name), taken at init
+    uint32_t     slot;          // index in the hub's node_tab while registered
+    atomic_uint  pins;          // array entries pointing at this node
+    node_vec_t  *subscribers;   // NULL when empty
+    node_vec_t  *subscriptions;
 #if MN_CACHE_SUPPORT_ENABLE
     void*        cache_p;
 #endif /* MN_CACHE_SUPPORT_ENABLE */
@@ -68,7 +76,16 @@ struct DataNodePriv {
 typedef \
 struct DataHub {
     char          name[MN_NODE_NAME_MAX_LEN];
-    ll_list_t     node_list;
+    SiMap_t      *name_map;     // node name -> slot in node_tab
+#if MN_CONF_STATIC_ALLOC
+    MycoNode_t   *node_tab[MN_CONF_MAX_NODES];
+    uint32_t      free_slots[MN_CONF_MAX_NODES];
+    uint32_t      free_num;
+#else
+    MycoNode_t  **node_tab;     // registered nodes, NULL for free slots
+#endif
+    uint32_t      node_tab_cap;
+    uint32_t      node_num;
     atomic_bool   is_inited;
 #if MN_CONF_USE_LOCK
     Rwlock_t      list_lock;
@@ -88,6 +105,81 @@ _Static_assert(sizeof(struct DataNodePriv) <= MYCONET_PRIV_DATA_SIZE,
 #define node_priv(node_p) ((struct DataNodePriv *)((node_p)->priv))
 #define hub_p() (&s_hub)
 
+#define NODE_SLOT_NONE   UINT32_MAX
+#define NODE_TAB_INIT_CAP 16
+
+//==============================================================================
+// Internal Fixed Block Pools (static allocation mode)
+//==============================================================================
+
+#if MN_CONF_STATIC_ALLOC
+
+typedef \
+struct blk_pool {
+    uint8_t     *mem;
+    size_t       blk_size;
+    uint32_t     blk_num;
+    uint32_t     carved;        // blocks handed out from mem at least once
+    void        *free_list;     // intrusive, first word of each free block
+    atomic_flag  lock;
+} blk_pool_t;
+
+#define BLK_SIZE(size) \
+    (((size) + _Alignof(max_align_t) - 1) & ~(_Alignof(max_align_t) - 1))
+
+#define BLK_POOL_DEFINE(pool, size, num) \
+    static _Alignas(max_align_t) uint8_t pool##_mem[BLK_SIZE(size) * (num)]; \
+    static blk_pool_t pool = { \
+        .mem = pool##_mem, \
+        .blk_size = BLK_SIZE(size), \
+        .blk_num = (num), \
+        .lock = ATOMIC_FLAG_INIT, \
+    }
+
+#if MN_CONF_USE_LOCK
+#define blk_pool_lock(pool) \
+    while (atomic_flag_test_and_set_explicit(&(pool)->lock, memory_order_acquire)) {}
+#define blk_pool_unlock(pool) \
+    atomic_flag_clear_explicit(&(pool)->lock, memory_order_release)
+#else
+#define blk_pool_lock(pool)
+#define blk_pool_unlock(pool)
+#endif
+
+static void *blk_alloc(blk_pool_t *pool)
+{
+    blk_pool_lock(pool);
+    void *blk = pool->free_list;
+    if (blk) {
+        pool->free_list = *(void **)blk;
+    } else if (pool->carved < pool->blk_num) {
+        blk = pool->mem + pool->blk_size * pool->carved++;
+    }
+    blk_pool_unlock(pool);
+    return blk;
+}
+
+static void blk_free(blk_pool_t *pool, void *blk)
+{
+    if (!blk) return;
+    blk_pool_lock(pool);
+    *(void **)blk = pool->free_list;
+    pool->free_list = blk;
+    blk_pool_unlock(pool);
+}
+
+BLK_POOL_DEFINE(s_vec_pool,
+                sizeof(struct node_vec) + sizeof(MycoNode_t *) * MN_CONF_MAX_SUBS,
+                MN_CONF_MAX_NODES * 2 + MN_CONF_SPARE_SUB_ARRAYS);
+
+#if MN_CACHE_SUPPORT_ENABLE
+BLK_POOL_DEFINE(s_cache_pool, MN_CONF_CACHE_BLOCK_SIZE, MN_CONF_CACHE_BLOCKS);
+#endif
+
+static _Alignas(max_align_t) uint8_t s_name_map_mem[SIMAP_MEM_SIZE(MN_CONF_MAX_NODES * 2)];
+
+#endif /* MN_CONF_STATIC_ALLOC */
+
 //==============================================================================
 // Dummy Node Definition
 //==============================================================================
@@ -105,85 +197,293 @@ MycoNode_t * const _dummyNode = &s_dummyNode;
 
 
 //==============================================================================
-// Internal Linked-List Implementation
+// Internal Node Vector Implementation
 //==============================================================================
 
-static int ll_list_init(ll_list_t *list) 
+#define node_vec_size(vec) ((vec) ? (int)(vec)->size : 0)
+
+#if MN_CONF_USE_LOCK
+static _Thread_local struct publish_frame *t_publishing;
+#else
+static struct publish_frame *t_publishing;
+#endif
+
+static inline MycoNode_t *node_vec_at(const node_vec_t *vec, int i)
+{
+    return atomic_load_explicit(&vec->data[i], memory_order_relaxed);
+}
+
+/* store an entry of a new array and pin its node */
+static inline void node_vec_set(node_vec_t *vec, int i, MycoNode_t *node_p)
+{
+    atomic_fetch_add_explicit(&node_priv(node_p)->pins, 1, memory_order_relaxed);
+    atomic_init(&vec->data[i], node_p);
+}
+
+static inline void node_unpin(MycoNode_t *node_p)
+{
+    atomic_fetch_sub_explicit(&node_priv(node_p)->pins, 1, memory_order_release);
+}
+
+static node_vec_t *node_vec_new(uint32_t size)
+{
+#if MN_CONF_STATIC_ALLOC
+    if (size > MN_CONF_MAX_SUBS) return NULL;
+    node_vec_t *vec = blk_alloc(&s_vec_pool);
+#else
+    node_vec_t *vec = Mem_alloc(sizeof(node_vec_t) + sizeof(MycoNode_t *) * size);
+#endif
+    if (!vec) return NULL;
+    atomic_init(&vec->refs, 1);
+    vec->size = size;
+    return vec;
+}
+
+static node_vec_t *node_vec_acquire(node_vec_t *vec)
+{
+    if (vec) atomic_fetch_add_explicit(&vec->refs, 1, memory_order_relaxed);
+    return vec;
+}
+
+static void node_vec_release(node_vec_t *vec)
+{
+    if (vec && atomic_fetch_sub_explicit(&vec->refs, 1, memory_order_acq_rel) == 1) {
+        for (uint32_t i = 0; i < vec->size; i++) {
+            MycoNode_t *node_p = node_vec_at(vec, (int)i);
+            if (node_p) node_unpin(node_p);
+        }
+#if MN_CONF_STATIC_ALLOC
+        blk_free(&s_vec_pool, vec);
+#else
+        Mem_free(vec);
+#endif
+    }
+}
+
+static int node_vec_find(const node_vec_t *vec, const MycoNode_t *node_p)
+{
+    for (int i = 0; i < node_vec_size(vec); i++) {
+        if (node_vec_at(vec, i) == node_p) return i;
+    }
+    return -1;
+}
+
+/* entries left, cleared ones do not count */
+static int node_vec_count(const node_vec_t *vec)
+{
+    int num = 0;
+    for (int i = 0; i < node_vec_size(vec); i++) {
+        if (node_vec_at(vec, i)) num++;
+    }
+    return num;
+}
+
+/* copy-on-write edits: build every new array first, then swap them all in
+ * with node_vec_replace, so an edit of two lists is all or nothing */
+static node_vec_t *node_vec_with(const node_vec_t *old, MycoNode_t *node_p)
+{
+    node_vec_t *vec = node_vec_new((uint32_t)node_vec_count(old) + 1);
+    if (!vec) return NULL;
+    int n = 0;
+    for (int i = 0; i < node_vec_size(old); i++) {
+        MycoNode_t *entry = node_vec_at(old, i);
+        if (entry) node_vec_set(vec, n++, entry);
+    }
+    node_vec_set(vec, n, node_p);
+    return vec;
+}
+
+/* *out is NULL when nothing is left, -1 when out of memory */
+static int node_vec_without(node_vec_t *old, const MycoNode_t *node_p, node_vec_t **out)
 {
-    if (!list) return -1;
-    list->head = list->tail = NULL;
-    list->size = 0;
+    const int pos = node_vec_find(old, node_p);
+    *out = NULL;
+    if (pos < 0) {
+        *out = node_vec_acquire(old);
+        return 0;
+    }
+    const int left = node_vec_count(old) - 1;
+    if (left == 0) return 0;
+
+    node_vec_t *vec = node_vec_new((uint32_t)left);
+    if (!vec) return -1;
+    int n = 0;
+    for (int i = 0; i < node_vec_size(old); i++) {
+        MycoNode_t *entry = node_vec_at(old, i);
+        if (entry && i != pos) node_vec_set(vec, n++, entry);
+    }
+    *out = vec;
     return 0;
 }
 
-static int ll_list_push_back(ll_list_t *list, MycoNode_t *data) 
+/* deinit fallback when a copy cannot be made: clear the entry in place */
+static void node_vec_clear(node_vec_t *vec, const MycoNode_t *node_p)
+{
+    const int pos = node_vec_find(vec, node_p);
+    if (pos < 0) return;
+    MycoNode_t *entry = atomic_exchange_explicit(&vec->data[pos], NULL, memory_order_relaxed);
+    if (entry) node_unpin(entry);
+}
+
+/* the caller holds the lock guarding *vec_pp */
+static void node_vec_replace(node_vec_t **vec_pp, node_vec_t *vec)
+{
+    node_vec_t *old = *vec_pp;
+    *vec_pp = vec;
+    node_vec_release(old);
+}
+
+/* drop the sub -> pub link on both sides for a node going away, cannot fail */
+static void node_unlink(MycoNode_t *sub_node, MycoNode_t *pub_node)
 {
-    if (!list || !data) return -1;
-    ll_node_t *node = Mem_alloc(sizeof(ll_node_t));
-    if (!node) return -1;
-    node->data = data;
-    node->next = NULL;
-    if (list->tail) {
-        list->tail->next = node;
+    struct DataNodePriv *sub_priv = node_priv(sub_node);
+    struct DataNodePriv *pub_priv = node_priv(pub_node);
+#if MN_CONF_USE_LOCK
+    Mutex_t *lock1, *lock2;
+    if ((uintptr_t)sub_node < (uintptr_t)pub_node) {
+        lock1 = &sub_priv->subscriptions_lock;
+        lock2 = &pub_priv->subscribers_lock;
     } else {
-        list->head = node;
+        lock1 = &pub_priv->subscribers_lock;
+        lock2 = &sub_priv->subscriptions_lock;
     }
-    list->tail = node;
-    list->size++;
-    return 0;
+    Mutex_lock(lock1);
+    Mutex_lock(lock2);
+#endif
+
+    node_vec_t *vec = NULL;
+    if (node_vec_without(pub_priv->subscribers, sub_node, &vec) == 0)
+        node_vec_replace(&pub_priv->subscribers, vec);
+    else
+        node_vec_clear(pub_priv->subscribers, sub_node);
+    if (node_vec_without(sub_priv->subscriptions, pub_node, &vec) == 0)
+        node_vec_replace(&sub_priv->subscriptions, vec);
+    else
+        node_vec_clear(sub_priv->subscriptions, pub_node);
+
+    Mutex_unlock(lock2);
+    Mutex_unlock(lock1);
 }
 
-static int ll_list_remove(ll_list_t *list, const MycoNode_t *data) 
+static MycoNode_t *node_vec_first(const node_vec_t *vec)
 {
-    if (!list || !data) return -1;
-    ll_node_t **pp = &list->head;
-    ll_node_t *prev = NULL;
-    
-    while (*pp != NULL) {
-        ll_node_t *current = *pp;
-        if (current->data == data) {
-            *pp = current->next;
-            if (current == list->tail) {
-                list->tail = prev;
-            }
-            Mem_free(current);
-            list->size--;
-            return 0;
-        }
-        prev = current;
-        pp = &current->next;
+    for (int i = 0; i < node_vec_size(vec); i++) {
+        MycoNode_t *entry = node_vec_at(vec, i);
+        if (entry) return entry;
     }
-    return -1;
+    return NULL;
 }
 
-static MycoNode_t *ll_list_find(ll_list_t *list, const char *name) 
+/* unlink every peer of a node going away, one at a time. The snapshot pins
+ * the peer, so it cannot finish a deinit of its own meanwhile. */
+static void node_unlink_all(MycoNode_t *node_p)
 {
-    if (!list || !name) return NULL;
+    struct DataNodePriv *priv = node_priv(node_p);
+    for (;;) {
+        Mutex_lock(&priv->subscriptions_lock);
+        node_vec_t *pubs = node_vec_acquire(priv->subscriptions);
+        Mutex_unlock(&priv->subscriptions_lock);
+        MycoNode_t *pub_node = node_vec_first(pubs);
+        if (pub_node) node_unlink(node_p, pub_node);
+        node_vec_release(pubs);
+        if (!pub_node) break;
+    }
+    for (;;) {
+        Mutex_lock(&priv->subscribers_lock);
+        node_vec_t *subs = node_vec_acquire(priv->subscribers);
+        Mutex_unlock(&priv->subscribers_lock);
+        MycoNode_t *sub_node = node_vec_first(subs);
+        if (sub_node) node_unlink(sub_node, node_p);
+        node_vec_release(subs);
+        if (!sub_node) break;
+    }
+}
 
-    for (ll_node_t *node = list->head; node != NULL; node = node->next) 
-    {
-        if (strcmp(node->data->name, name) == 0) {
-            return node->data;
+/* Wait until no array points at the node, so no publish can call it any
+ * more. Arrays the publishes on this thread are walking are not waited for,
+ * a node may be deinitialized from a callback. */
+static void node_wait_unpinned(MycoNode_t *node_p)
+{
+    uint32_t own = 0;
+    for (const struct publish_frame *f = t_publishing; f; f = f->prev) {
+        bool seen = false;
+        for (const struct publish_frame *g = t_publishing; g != f; g = g->prev) {
+            if (g->subs == f->subs) seen = true;
         }
+        if (!seen && node_vec_find(f->subs, node_p) >= 0) own++;
+    }
+    while (atomic_load_explicit(&node_priv(node_p)->pins, memory_order_acquire) > own) {
+        Thread_yield();
     }
-    return NULL;
 }
 
-static void ll_list_clear(ll_list_t *list) 
+//==============================================================================
+// Internal Node Index (hub list_lock held by the caller)
+//==============================================================================
+
+static MycoNode_t *hub_find(const char *name, uint32_t hash)
 {
-    if (!list) return;
+    uint32_t slot = 0;
+    if (simap_get_hashed(hub_p()->name_map, name, hash, &slot) != SIMAP_OK) 
+        return NULL;
+    if (slot >= hub_p()->node_tab_cap) return NULL;
+    return hub_p()->node_tab[slot];
+}
 
-    ll_node_t *node = list->head;
-    while (node) {
-        ll_node_t *next = node->next;
-        Mem_free(node);
-        node = next;
+static int hub_insert(MycoNode_t *node_p)
+{
+    MycoNet_t *hub = hub_p();
+#if MN_CONF_STATIC_ALLOC
+    if (hub->free_num == 0) return -1;
+    uint32_t slot = hub->free_slots[hub->free_num - 1];
+#else
+    uint32_t slot = 0;
+    while (slot < hub->node_tab_cap && hub->node_tab[slot] != NULL) slot++;
+
+    if (slot == hub->node_tab_cap) {
+        uint32_t new_cap = hub->node_tab_cap ? hub->node_tab_cap * 2 : NODE_TAB_INIT_CAP;
+        MycoNode_t **tab = Mem_alloc(sizeof(MycoNode_t *) * new_cap);
+        if (!tab) return -1;
+        memset(tab, 0, sizeof(MycoNode_t *) * new_cap);
+        if (hub->node_tab) {
+            memcpy(tab, hub->node_tab, sizeof(MycoNode_t *) * hub->node_tab_cap);
+            Mem_free(hub->node_tab);
+        }
+        hub->node_tab = tab;
+        hub->node_tab_cap = new_cap;
     }
-    ll_list_init(list);
+#endif
+
+    if (simap_set_hashed(hub->name_map, node_p->name, node_priv(node_p)->name_hash, slot) != SIMAP_OK)
+        return -1;
+    hub->node_tab[slot] = node_p;
+    hub->node_num++;
+#if MN_CONF_STATIC_ALLOC
+    hub->free_num--;
+#endif
+    node_priv(node_p)->slot = slot;
+    return 0;
 }
 
-#define ll_list_for_each(list, node_p) \
-    for (ll_node_t *node_p = (list)->head; node_p != NULL; node_p = (node_p)->next)
+static int hub_erase(MycoNode_t *node_p)
+{
+    MycoNet_t *hub = hub_p();
+    uint32_t slot = node_priv(node_p)->slot;
+    if (slot >= hub->node_tab_cap || hub->node_tab[slot] != node_p) return -1;
+
+    simap_delete_hashed(hub->name_map, node_p->name, node_priv(node_p)->name_hash);
+    hub->node_tab[slot] = NULL;
+    hub->node_num--;
+#if MN_CONF_STATIC_ALLOC
+    hub->free_slots[hub->free_num++] = slot;
+#endif
+    node_priv(node_p)->slot = NODE_SLOT_NONE;
+    return 0;
+}
+
+#define hub_for_each_node(node_p) \
+    for (uint32_t _i = 0; _i < hub_p()->node_tab_cap; _i++) \
+        for (MycoNode_t *node_p = hub_p()->node_tab[_i]; node_p != NULL; node_p = NULL)
 
 //==============================================================================
 // Internal Check Helpers
@@ -230,10 +530,29 @@ MN_API int MycoNet_Init(void)
         return MN_ERR_INITIALIZED;
     }
 
-    ll_list_init(&hub_p()->node_list);
+    hub_p()->node_num = 0;
+#if MN_CONF_STATIC_ALLOC
+    hub_p()->node_tab_cap = MN_CONF_MAX_NODES;
+    hub_p()->free_num = MN_CONF_MAX_NODES;
+    for (uint32_t i = 0; i < MN_CONF_MAX_NODES; i++) {
+        hub_p()->node_tab[i] = NULL;
+        hub_p()->free_slots[i] = MN_CONF_MAX_NODES - 1 - i; // hand out slot 0 first
+    }
+    hub_p()->name_map = simap_create_in(s_name_map_mem, sizeof(s_name_map_mem));
+#else
+    hub_p()->node_tab = NULL;
+    hub_p()->node_tab_cap = 0;
+    hub_p()->name_map = simap_create(NODE_TAB_INIT_CAP);
+#endif
+    if (!hub_p()->name_map) {
+        atomic_store(&hub_p()->is_inited, false);
+        return MN_ERR_NOMEM;
+    }
 
 #if MN_CONF_USE_LOCK
     if (Rwlock_init(&hub_p()->list_lock) != 0) {
+        simap_destroy(hub_p()->name_map);
+        hub_p()->name_map = NULL;
         atomic_store(&hub_p()->is_inited, false);
         return MN_ERR_FAIL;
     }
@@ -263,10 +582,17 @@ MN_API int MycoNet_Deinit(void)
     }
 
     Rwlock_wrlock(&hub_p()->list_lock);
-    ll_list_for_each(&hub_p()->node_list, node) {
-        MycoNet_DeinitNode(node->data);
+    hub_for_each_node(node) {
+        MycoNet_DeinitNode(node);
     }
-    ll_list_clear(&hub_p()->node_list);
+#if !MN_CONF_STATIC_ALLOC
+    Mem_free(hub_p()->node_tab);
+    hub_p()->node_tab = NULL;
+#endif
+    hub_p()->node_tab_cap = 0;
+    hub_p()->node_num = 0;
+    simap_destroy(hub_p()->name_map);
+    hub_p()->name_map = NULL;
     Rwlock_wrunlock(&hub_p()->list_lock);
     Rwlock_destroy(&hub_p()->list_lock);
     return MN_OK;
@@ -278,7 +604,7 @@ MN_API int MycoNet_GetNodeNum(void)
     if ((err = check_hub_inited()) != MN_OK) return err;
 
     Rwlock_rdlock(&hub_p()->list_lock);
-    int size = hub_p()->node_list.size;
+    int size = (int)hub_p()->node_num;
     Rwlock_rdunlock(&hub_p()->list_lock);
     return size;
 }
@@ -288,8 +614,9 @@ MN_API MycoNode_t *MycoNet_SearchNode(const char *name)
     if (name == NULL) return NULL;
     if (check_hub_inited() != MN_OK) return NULL;
 
+    const uint32_t hash = simap_hash(name);
     Rwlock_rdlock(&hub_p()->list_lock);
-    MycoNode_t *result = ll_list_find(&hub_p()->node_list, name);
+    MycoNode_t *result = hub_find(name, hash);
     Rwlock_rdunlock(&hub_p()->list_lock);
     return result;
 }
@@ -324,8 +651,8 @@ MN_API int MycoNet_PrintNodeList(int (*print_)(const char *fmt, ...))
 
     Rwlock_rdlock(&hub_p()->list_lock);
     print_("Node List:\n");
-    ll_list_for_each(&hub_p()->node_list, node_p) {
-        print_("\t%s\n", node_p->data->name);
+    hub_for_each_node(node_p) {
+        print_("\t%s\n", node_p->name);
     }
     Rwlock_rdunlock(&hub_p()->list_lock);
     return MN_OK;
@@ -349,8 +676,10 @@ MN_API int MycoNet_InitNode(MycoNode_t *node_p)
     memset(node_p->priv, 0, MYCONET_PRIV_DATA_SIZE);
     atomic_store(&priv->is_inited, true);
     atomic_store(&priv->is_registered, false);
-    ll_list_init(&priv->subscribers);
-    ll_list_init(&priv->subscriptions);
+    priv->name_hash = simap_hash(node_p->name);
+    priv->slot = NODE_SLOT_NONE;
+    priv->subscribers = NULL;
+    priv->subscriptions = NULL;
     Mutex_init(&priv->subscribers_lock);
     Mutex_init(&priv->subscriptions_lock);
 
@@ -366,7 +695,15 @@ MN_API int MycoNet_InitNode(MycoNode_t *node_p)
             return MN_ERR_INVALID; // Cached nodes must have a defined size
         }
 
+#if MN_CONF_STATIC_ALLOC
+        if (node_p->size > MN_CONF_CACHE_BLOCK_SIZE) {
+            atomic_store(&priv->is_inited, false);
+            return MN_ERR_NOMEM;
+        }
+        priv->cache_p = blk_alloc(&s_cache_pool);
+#else
         priv->cache_p = Mem_alloc(node_p->size);
+#endif
         if (!priv->cache_p) {
             atomic_store(&priv->is_inited, false);
             return MN_ERR_NOMEM;
@@ -392,13 +729,27 @@ MN_API int MycoNet_DeinitNode(MycoNode_t *node_p)
         return MN_ERR_NOTINITIALIZED; // Node not initialized
     }
 
-    if (atomic_load(&priv->is_registered)) {
-        MycoNet_RemoveNode(node_p);
+    // MycoNet_RemoveNode would refuse a node no longer marked inited, and
+    // MycoNet_Deinit already holds the list lock when it gets here
+    bool registered = true;
+    if (check_hub_inited() == MN_OK &&
+        atomic_compare_exchange_strong(&priv->is_registered, &registered, false)) {
+        Rwlock_wrlock(&hub_p()->list_lock);
+        hub_erase(node_p);
+        Rwlock_wrunlock(&hub_p()->list_lock);
     }
 
+    // no publish may call into the node once this returns
+    node_unlink_all(node_p);
+    node_wait_unpinned(node_p);
+
 #if MN_CACHE_SUPPORT_ENABLE
     if (priv->cache_p) {
+#if MN_CONF_STATIC_ALLOC
+        blk_free(&s_cache_pool, priv->cache_p);
+#else
         Mem_free(priv->cache_p);
+#endif
         priv->cache_p = NULL;
     }
     Rwlock_destroy(&priv->cache_lock);
@@ -406,8 +757,10 @@ MN_API int MycoNet_DeinitNode(MycoNode_t *node_p)
 
     Mutex_destroy(&priv->subscribers_lock);
     Mutex_destroy(&priv->subscriptions_lock);
-    ll_list_clear(&priv->subscribers);
-    ll_list_clear(&priv->subscriptions);
+    node_vec_release(priv->subscribers);
+    node_vec_release(priv->subscriptions);
+    priv->subscribers = NULL;
+    priv->subscriptions = NULL;
     
     return MN_OK;
 }
@@ -425,12 +778,12 @@ MN_API int MycoNet_PushBackNode(MycoNode_t *node_p)
     }
 
     Rwlock_wrlock(&hub_p()->list_lock);
-    if (ll_list_find(&hub_p()->node_list, node_p->name)) {
+    if (hub_find(node_p->name, node_priv(node_p)->name_hash)) {
         Rwlock_wrunlock(&hub_p()->list_lock);
         atomic_store(&node_priv(node_p)->is_registered, false);
         return MN_ERR_EXIST;
     }
-    int ret = ll_list_push_back(&hub_p()->node_list, node_p);
+    int ret = hub_insert(node_p);
     Rwlock_wrunlock(&hub_p()->list_lock);
 
     if (ret != 0) {
@@ -452,7 +805,7 @@ MN_API int MycoNet_RemoveNode(MycoNode_t *node_p)
     }
 
     Rwlock_wrlock(&hub_p()->list_lock);
-    int ret = ll_list_remove(&hub_p()->node_list, node_p);
+    int ret = hub_erase(node_p);
     Rwlock_wrunlock(&hub_p()->list_lock);
 
     return (ret == 0) ? MN_OK : MN_ERR_NOTFOUND;
@@ -464,7 +817,7 @@ MN_API int MycoNet_GetNodePubNum(MycoNode_t *node_p)
     if (check_node_inited(node_p) != MN_OK) return MN_ERR_NOTINITIALIZED;
 
     Mutex_lock(&node_priv(node_p)->subscribers_lock);
-    int size = node_priv(node_p)->subscribers.size;
+    int size = node_vec_count(node_priv(node_p)->subscribers);
     Mutex_unlock(&node_priv(node_p)->subscribers_lock);
     return size;
 }
@@ -475,7 +828,7 @@ MN_API int MycoNet_GetNodeSubNum(MycoNode_t *node_p)
     if (check_node_inited(node_p) != MN_OK) return MN_ERR_NOTINITIALIZED;
 
     Mutex_lock(&node_priv(node_p)->subscriptions_lock);
-    int size = node_priv(node_p)->subscriptions.size;
+    int size = node_vec_count(node_priv(node_p)->subscriptions);
     Mutex_unlock(&node_priv(node_p)->subscriptions_lock);
     return size;
 }
@@ -515,12 +868,19 @@ MN_API int MycoNet_NodeSubscribe(MycoNode_t *node_p, const char *name)
 #endif
 
     int ret = MN_OK;
-    if (!ll_list_find(&node_priv(node_p)->subscriptions, pub_node->name)) 
+    if (check_node_inited(pub_node) != MN_OK) {
+        ret = MN_ERR_NOTFOUND; // lost a race with its deinit
+    }
+    else if (node_vec_find(node_priv(node_p)->subscriptions, pub_node) < 0) 
     {
-        if (ll_list_push_back(&node_priv(node_p)->subscriptions, pub_node) == 0) {
-            ll_list_push_back(&node_priv(pub_node)->subscribers, node_p);
-        } else {
+        node_vec_t *pubs = node_vec_with(node_priv(node_p)->subscriptions, pub_node);
+        node_vec_t *subs = pubs ? node_vec_with(node_priv(pub_node)->subscribers, node_p) : NULL;
+        if (!subs) {
+            node_vec_release(pubs);
             ret = MN_ERR_NOMEM;
+        } else {
+            node_vec_replace(&node_priv(node_p)->subscriptions, pubs);
+            node_vec_replace(&node_priv(pub_node)->subscribers, subs);
         }
     } 
     else {
@@ -557,10 +917,17 @@ MN_API int MycoNet_NodeUnsubscribe(MycoNode_t *node_p, const char *name)
 #endif
 
     int ret = MN_OK;
-    if (ll_list_remove(&node_priv(node_p)->subscriptions, pub_node) == 0) {
-        ll_list_remove(&node_priv(pub_node)->subscribers, node_p);
-    } else {
+    node_vec_t *subs = NULL, *pubs = NULL;
+    if (node_vec_find(node_priv(node_p)->subscriptions, pub_node) < 0) {
         ret = MN_ERR_NOTFOUND;
+    } else if (node_vec_without(node_priv(pub_node)->subscribers, node_p, &subs) != 0 ||
+               node_vec_without(node_priv(node_p)->subscriptions, pub_node, &pubs) != 0) {
+        // neither side changes
+        node_vec_release(subs);
+        ret = MN_ERR_NOMEM;
+    } else {
+        node_vec_replace(&node_priv(pub_node)->subscribers, subs);
+        node_vec_replace(&node_priv(node_p)->subscriptions, pubs);
     }
 
     Mutex_unlock(lock2);
@@ -639,12 +1006,19 @@ static int node_publish(MycoNode_t *node_p, const void *data_p, int size, int ju
     uint32_t size_cast = just_signal ? 0 : (uint32_t)size;
     EventCode_t event_type = just_signal ? EVENT_PUBLISH_SIG : EVENT_PUBLISH;
 
-    // notify all subscribers.
+    // notify all subscribers, from a snapshot so callbacks run unlocked
+    // and may (un)subscribe without deadlocking.
     Mutex_lock(&priv->subscribers_lock);
-    ll_list_for_each(&priv->subscribers, sub_ll_node) 
+    node_vec_t *subs = node_vec_acquire(priv->subscribers);
+    Mutex_unlock(&priv->subscribers_lock);
+    struct publish_frame frame = { subs, t_publishing };
+    t_publishing = &frame;
+
+    // the array pins its entries, a deinit waits for it before returning
+    for (int i = 0; i < node_vec_size(subs); i++) 
     {
-        MycoNode_t* sub_node = sub_ll_node->data;
-        if (sub_node == NULL) continue;
+        MycoNode_t* sub_node = node_vec_at(subs, i);
+        if (sub_node == NULL || check_node_inited(sub_node) != MN_OK) continue;
 
         const int supported = sub_node->event_cb && \
                             (sub_node->event_msk & event_type);
@@ -660,7 +1034,8 @@ static int node_publish(MycoNode_t *node_p, const void *data_p, int size, int ju
 
         SendEvent(sub_node, &param);
     }
-    Mutex_unlock(&priv->subscribers_lock);
+    t_publishing = frame.prev;
+    node_vec_release(subs);
 
     return MN_OK;
 }
@@ -724,7 +1099,7 @@ MN_API int MycoNet_NodeNotify(MycoNode_t *node_p, const char *name, const void *
     if (!target_node) return MN_ERR_NOTFOUND;
 
 #if MN_RESTRICT_NOTIFY_SIZE_CHECK_ENABLE
-    if (size != target_node->notify_size) return MN_ERR_SIZE_MISMATCH;
+    if ((uint32_t)size != target_node->notify_size) return MN_ERR_SIZE_MISMATCH;
 #endif
 
     // check if the target node supports the NOTIFY event
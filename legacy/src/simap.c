@@ -23,6 +23,7 @@ typedef struct {
         ENTRY_DELETED   // Deleted slot (tombstone)
     } state;
     int id;
+    uint32_t hash;
     char key[MAX_KEY_LEN];
 } SiItem_t;
 
@@ -31,12 +32,13 @@ struct SiMap {
     uint32_t capacity;
     pthread_rwlock_t lock;
     uint32_t count;
+    bool fixed;         // entries live in caller memory, never resized
 };
 
 
 static uint64_t fnv1a_hash(const char *key);
 static int resize_simap(SiMap_t *map);
-static SiItem_t *find_item(SiMap_t *map, const char *key);
+static SiItem_t *find_item(SiMap_t *map, const char *key, uint32_t hash);
 
 // FNV-1a hash function implementation
 static uint64_t fnv1a_hash(const char *key)
@@ -51,9 +53,8 @@ static uint64_t fnv1a_hash(const char *key)
 }
 
 // Find entry in the hash table
-static SiItem_t *find_item(SiMap_t *map, const char *key)
+static SiItem_t *find_item(SiMap_t *map, const char *key, uint32_t hash)
 {
-    uint64_t hash = fnv1a_hash(key);
     size_t start_index = (size_t)(hash & (map->capacity - 1));
     size_t index = start_index;
 
@@ -69,7 +70,7 @@ static SiItem_t *find_item(SiMap_t *map, const char *key)
                 if (tombstone == NULL) tombstone = entry;
                 break;
             case ENTRY_OCCUPIED:
-                if (strcmp(key, entry->key) == 0)
+                if (entry->hash == hash && strcmp(key, entry->key) == 0)
                     return entry;
                 break;
         }
@@ -98,7 +99,7 @@ static int resize_simap(SiMap_t *map)
     for (uint32_t i = 0; i < old_capacity; i++) {
         SiItem_t *old_entry = &map->entries[i];
         if (old_entry->state == ENTRY_OCCUPIED) {
-            SiItem_t *new_entry = &new_entries[fnv1a_hash(old_entry->key) & (new_capacity - 1)];
+            SiItem_t *new_entry = &new_entries[old_entry->hash & (new_capacity - 1)];
             // Handle collisions with linear probing
             while (new_entry->state == ENTRY_OCCUPIED) {
                 new_entry = &new_entries[(new_entry - new_entries + 1) & (new_capacity - 1)];
@@ -158,6 +159,7 @@ SIMAP_API SiMap_t *simap_create(uint32_t capacity)
 
     map->capacity = capacity;
     map->count = 0;
+    map->fixed = false;
     if (pthread_rwlock_init(&map->lock, NULL) != 0) {
         free(map->entries);
         free(map);
@@ -167,6 +169,34 @@ SIMAP_API SiMap_t *simap_create(uint32_t capacity)
     return map;
 }
 
+SIMAP_API SiMap_t *simap_create_in(void *mem, size_t mem_size)
+{
+    if (!mem || mem_size < sizeof(SiMap_t)) return NULL;
+
+    const size_t header = (sizeof(SiMap_t) + _Alignof(SiItem_t) - 1) & ~(_Alignof(SiItem_t) - 1);
+    if (mem_size < header + sizeof(SiItem_t) * 16) return NULL;
+
+    uint32_t capacity = 16;
+    while ((size_t)capacity * 2 <= (mem_size - header) / sizeof(SiItem_t) && capacity < (UINT32_MAX >> 1)) {
+        capacity *= 2;
+    }
+
+    SiMap_t *map = (SiMap_t *)mem;
+    map->entries = (SiItem_t *)((uint8_t *)mem + header);
+    for (uint32_t i = 0; i < capacity; i++) {
+        map->entries[i].state = ENTRY_EMPTY;
+    }
+
+    map->capacity = capacity;
+    map->count = 0;
+    map->fixed = true;
+    if (pthread_rwlock_init(&map->lock, NULL) != 0) {
+        return NULL;
+    }
+
+    return map;
+}
+
 SIMAP_API int simap_destroy(SiMap_t *map)
 {
     if (!map) return SIMAP_ERR_NULL_PTR;
@@ -175,12 +205,24 @@ SIMAP_API int simap_destroy(SiMap_t *map)
     if (pthread_rwlock_destroy(&map->lock) != 0) {
         result = SIMAP_ERR_LOCK_FAILED;
     }
+    if (map->fixed) return result;
     free(map->entries);
     free(map);
     return result;
 }
 
+SIMAP_API uint32_t simap_hash(const char *key)
+{
+    return key ? (uint32_t)fnv1a_hash(key) : 0;
+}
+
 SIMAP_API int simap_set(SiMap_t *map, const char *key, uint32_t id)
+{
+    if (!map || !key) return SIMAP_ERR_NULL_PTR;
+    return simap_set_hashed(map, key, simap_hash(key), id);
+}
+
+SIMAP_API int simap_set_hashed(SiMap_t *map, const char *key, uint32_t hash, uint32_t id)
 {
     if (!map || !key) return SIMAP_ERR_NULL_PTR;
     
@@ -195,14 +237,14 @@ SIMAP_API int simap_set(SiMap_t *map, const char *key, uint32_t id)
     }
 
     // Check if resize is needed
-    if ((double)(map->count + 1) / map->capacity > MAX_LOAD_FACTOR) {
+    if (!map->fixed && (double)(map->count + 1) / map->capacity > MAX_LOAD_FACTOR) {
         if (resize_simap(map) != 0) {
             pthread_rwlock_unlock(&map->lock);
             return SIMAP_ERR_RESIZE_FAILED;
         }
     }
 
-    SiItem_t *entry = find_item(map, key);
+    SiItem_t *entry = find_item(map, key, hash);
 
     if (entry == NULL) {
         pthread_rwlock_unlock(&map->lock);
@@ -218,6 +260,7 @@ SIMAP_API int simap_set(SiMap_t *map, const char *key, uint32_t id)
     entry->key[MAX_KEY_LEN - 1] = '\0';
     entry->state = ENTRY_OCCUPIED;
     entry->id = id;
+    entry->hash = hash;
 
     map->count++;
 
@@ -226,6 +269,12 @@ SIMAP_API int simap_set(SiMap_t *map, const char *key, uint32_t id)
 }
 
 SIMAP_API int simap_get(SiMap_t *map, const char *key, uint32_t *id)
+{
+    if (!map || !key || !id) return SIMAP_ERR_NULL_PTR;
+    return simap_get_hashed(map, key, simap_hash(key), id);
+}
+
+SIMAP_API int simap_get_hashed(SiMap_t *map, const char *key, uint32_t hash, uint32_t *id)
 {
     if (!map || !key || !id) return SIMAP_ERR_NULL_PTR;
     
@@ -239,7 +288,7 @@ SIMAP_API int simap_get(SiMap_t *map, const char *key, uint32_t *id)
         return SIMAP_ERR_LOCK_FAILED;
     }
     
-    SiItem_t *entry = find_item(map, key);
+    SiItem_t *entry = find_item(map, key, hash);
     
     if (entry != NULL && entry->state == ENTRY_OCCUPIED) {
         *id = entry->id;
@@ -252,6 +301,12 @@ SIMAP_API int simap_get(SiMap_t *map, const char *key, uint32_t *id)
 }
 
 SIMAP_API int simap_delete(SiMap_t *map, const char *key)
+{
+    if (!map || !key) return SIMAP_ERR_NULL_PTR;
+    return simap_delete_hashed(map, key, simap_hash(key));
+}
+
+SIMAP_API int simap_delete_hashed(SiMap_t *map, const char *key, uint32_t hash)
 {
     if (!map || !key) return SIMAP_ERR_NULL_PTR;
     
@@ -265,7 +320,7 @@ SIMAP_API int simap_delete(SiMap_t *map, const char *key)
         return SIMAP_ERR_LOCK_FAILED;
     }
     
-    SiItem_t *entry = find_item(map, key);
+    SiItem_t *entry = find_item(map, key, hash);
     
     if (entry != NULL && entry->state == ENTRY_OCCUPIED) {
         entry->state = ENTRY_DELETED;
@@ -26,9 +26,21 @@ typedef struct SiMap SiMap_t;
 // Create a string-ID map with the `capacity`
 SIMAP_API SiMap_t *simap_create(uint32_t capacity);
 
+// Upper bound of the memory simap_create_in needs for `capacity` entries
+#define SIMAP_MEM_SIZE(capacity) \
+    (sizeof(pthread_rwlock_t) + 64 + (size_t)(capacity) * (MAX_KEY_LEN + 16))
+
+// Create a fixed-size map inside `mem`, which must be pointer aligned and
+// outlive the map. It never allocates and refuses new keys once full.
+SIMAP_API SiMap_t *simap_create_in(void *mem, size_t mem_size);
+
 // Destroy the string-ID map and free all associated memory
 SIMAP_API int simap_destroy(SiMap_t *map);
 
+// FNV-1a hash of `key`, callers that look up the same key repeatedly can
+// compute it once and use the *_hashed variants below
+SIMAP_API uint32_t simap_hash(const char *key);
+
 // Set a key-value pair in the map
 SIMAP_API int simap_set(SiMap_t *map, const char *key, uint32_t id);
 
@@ -38,6 +50,11 @@ SIMAP_API int simap_get(SiMap_t *map, const char *key, uint32_t *id);
 // Delete a key from the map
 SIMAP_API int simap_delete(SiMap_t *map, const char *key);
 
+// Same as above, `hash` must be simap_hash(key)
+SIMAP_API int simap_set_hashed(SiMap_t *map, const char *key, uint32_t hash, uint32_t id);
+SIMAP_API int simap_get_hashed(SiMap_t *map, const char *key, uint32_t hash, uint32_t *id);
+SIMAP_API int simap_delete_hashed(SiMap_t *map, const char *key, uint32_t hash);
+
 // Convert error code to human-readable string
 SIMAP_API const char *simap_strerror(int err);
 
@@ -1,6 +1,7 @@
 #include "myconet.hpp"
 #include <array>
 #include <atomic>
+#include <chrono>
 #include <functional>
 #include <list>
 #include <map>
@@ -10,33 +11,158 @@
 #include <stdlib.h>
 #include <string.h>
 #include <string>
+#include <thread>
 #include <vector>
 
 using namespace MycoNets;
 
 std::map<std::string, std::shared_ptr<MycoNet>> MycoNet::insts;
 std::mutex MycoNet::insts_mutex;
+std::atomic<MycoNet *> MycoNet::default_inst{nullptr};
+
+static constexpr uint32_t log2_of(uint32_t n) { return n <= 1 ? 0 : 1 + log2_of(n >> 1); }
+static constexpr uint32_t RPC_INDEX_BITS = log2_of(MN_CONFIG_RPC_SLOTS);
+static constexpr uint32_t RPC_INDEX_MASK = MN_CONFIG_RPC_SLOTS - 1;
+
+static inline int64_t steady_now_ns()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// Marks a stretch where raw node/list pointers are in use. Only counts on
+// Threading::SINGLE instances, and empties `retired` when the last one ends.
+class MycoNet::Borrow {
+public:
+    explicit Borrow(MycoNet &net) : net(net.threading == Threading::SINGLE ? &net : nullptr) {
+        if (this->net) this->net->borrows++;
+    }
+    Borrow(Borrow &&other) : net(other.net) { other.net = nullptr; }
+    Borrow(const Borrow &) = delete;
+    Borrow &operator=(const Borrow &) = delete;
+    ~Borrow() {
+        if (net == nullptr || --net->borrows > 0 || net->retired.empty()) return;
+        // destructors run with the list already detached
+        std::vector<std::shared_ptr<const void>> dead;
+        dead.swap(net->retired);
+    }
+
+private:
+    MycoNet *net;
+};
+
+// Result of Lookup: owns a reference on shared instances, borrows the
+// registry's on single-threaded ones
+class MycoNet::NodeHold {
+public:
+    explicit NodeHold(MycoNet &net) : borrow(net) {}
+    MycoNode *operator->() const { return node; }
+    MycoNode &operator*() const { return *node; }
+    explicit operator bool() const { return node != nullptr; }
+
+private:
+    friend class MycoNet;
+    Borrow borrow;
+    MycoNode *node = nullptr;
+    std::shared_ptr<MycoNode> owner;
+};
+
+// Workers for parallel fan-out. A thread waiting for its batch runs queued
+// jobs meanwhile, so callbacks that fan out in parallel themselves cannot
+// leave every worker blocked.
+class MycoNet::FanoutPool {
+public:
+    explicit FanoutPool(unsigned threads) {
+        for (unsigned i = 0; i < threads; i++) workers.emplace_back([this]() { Run(); });
+    }
+    ~FanoutPool() {
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            stopping = true;
+        }
+        cv.notify_all();
+        for (auto &worker : workers) worker.join();
+    }
+    size_t Workers() const { return workers.size(); }
+
+    void Submit(std::function<void ()> job) {
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            jobs.push_back(std::move(job));
+        }
+        cv.notify_one();
+    }
+    // last touch of `pending` by a job
+    void Done(std::atomic<int> &pending) {
+        if (pending.fetch_sub(1) != 1) return;
+        std::lock_guard<std::mutex> guard(lock);
+        cv.notify_all();
+    }
+    void Wait(const std::atomic<int> &pending) {
+        std::unique_lock<std::mutex> guard(lock);
+        while (pending.load() > 0) {
+            if (!RunOne(guard)) cv.wait(guard);
+        }
+    }
+
+private:
+    bool RunOne(std::unique_lock<std::mutex> &guard) {
+        if (jobs.empty()) return false;
+        std::function<void ()> job = std::move(jobs.front());
+        jobs.pop_front();
+        guard.unlock();
+        job();
+        guard.lock();
+        return true;
+    }
+    void Run() {
+        std::unique_lock<std::mutex> guard(lock);
+        for (;;) {
+            if (RunOne(guard)) continue;
+            if (stopping) return; // drained
+            cv.wait(guard);
+        }
+    }
+
+    std::mutex lock;
+    std::condition_variable cv;
+    std::list<std::function<void ()>> jobs;
+    std::vector<std::thread> workers;
+    bool stopping = false;
+};
 
 MycoNode::MycoNode(std::string name, const NodeParam &param, MycoNet &net) :
     node_name(name),
     id(INVALID_ID),
     conflags(param.conflags), 
-    net(net),
-    event_cb(param.event_cb),
     event_mask(param.event_msk),
+    check_notify_size(false),
+    using_cache(false),
+    trigger_latch(false),
+    varsize(param.size > 0 && (param.conflags & CONF_CACHED) && (param.conflags & CONF_VARSIZE)),
+    huge_pages(param.huge_pages),
+    numa_node(param.numa_node),
+    history_depth(param.history > 1 && !(param.conflags & CONF_VARSIZE) ? param.history : 1),
+    fanout_threshold(net.threading == Threading::SHARED ? param.fanout_threshold : 0),
+    fanout_wait(param.fanout_wait),
+    partitions(param.partitions ? param.partitions : MN_CONFIG_PARTITIONS),
     cache_size(param.size),
     notify_size(param.notify_size),
+    net(net),
     user_data(param.user_data),
-    check_notify_size(false),
-    using_cache(false),
-    trigger_latch(false)
+    event_cb(param.event_cb)
 {
     if (event_cb == nullptr)
         event_mask = EVENT_NONE;
+    state.placed = numa_node != NUMA_PUBLISHER;
+    const bool locked = net.threading == Threading::SHARED;
+    state.lock.enabled = pulled.lock.enabled = links.lock.enabled = locked;
     
-    if (cache_size > 0 && conflags & CONF_CACHED) {
-        cache.resize(cache_size);
-        using_cache = true;
+    if (varsize) {
+        using_cache = true; // grows with the samples, see Grow
+    } else if (cache_size > 0 && conflags & CONF_CACHED) {
+        cache = MsgPool::AllocPlaced(cache_size * history_depth, numa_node, huge_pages);
+        using_cache = static_cast<bool>(cache);
     }
 
     if (conflags & CONF_LATCHED && using_cache)
@@ -47,119 +173,638 @@ MycoNode::MycoNode(std::string name, const NodeParam &param, MycoNet &net) :
 }
 
 int MycoNode::Subscribe(std::string target_node_name)
+{
+    return Subscribe(std::move(target_node_name), std::string());
+}
+
+int MycoNode::Subscribe(std::string target_node_name, std::string group, GroupPolicy policy)
+{
+    return Subscribe(std::move(target_node_name), std::move(group), policy, nullptr);
+}
+
+int MycoNode::Subscribe(std::string target_node_name, const FilterRule &rule)
+{
+    if (rule.op > FilterRule::GE) return MN_ERR_INVALID;
+    if (rule.width != 1 && rule.width != 2 && rule.width != 4 && rule.width != 8) return MN_ERR_INVALID;
+    auto filter = std::make_shared<SubFilter>();
+    filter->has_rule = true;
+    filter->rule = rule;
+    return Subscribe(std::move(target_node_name), std::string(), GroupPolicy::ROUND_ROBIN, std::move(filter));
+}
+
+int MycoNode::Subscribe(std::string target_node_name, FilterFn filter)
+{
+    std::shared_ptr<SubFilter> sub_filter;
+    if (filter) {
+        sub_filter = std::make_shared<SubFilter>();
+        sub_filter->pred = std::move(filter);
+    }
+    return Subscribe(std::move(target_node_name), std::string(), GroupPolicy::ROUND_ROBIN, std::move(sub_filter));
+}
+
+int MycoNode::Subscribe(std::string target_node_name, std::string group, GroupPolicy policy,
+                        std::shared_ptr<const SubFilter> filter)
 {
     if (event_cb == nullptr || event_mask == EVENT_NONE)
         return MN_ERR_NOSUPPORT;
 
     auto [target_id, target_node] = net.GetNode(target_node_name);
 
-    // add to pending list
+    // add to pending list, re-checked under the shard lock NewNode takes
     if (target_id == INVALID_ID)
     {
-        PendingItem item = {};
-        item.node_id = id;
-        item.target_node_name = target_node_name;
-
-        std::lock_guard<std::mutex> lock(net.pending_list_mutex);
-        net.pending_list.push_back(item);
-
-        return MN_INFO_PENDING;
+        auto &shard = net.NameShardOf(target_node_name);
+        std::unique_lock<OptSharedMutex> lock(shard.lock);
+        auto it = shard.nodes.find(target_node_name);
+        if (it == shard.nodes.end()) {
+            PendingItem item = {};
+            item.node_id = MyID();
+            item.target_node_name = target_node_name;
+            item.group = group;
+            item.policy = policy;
+            item.filter = filter;
+            shard.pending.push_back(item);
+            return MN_INFO_PENDING;
+        }
+        target_node = it->second;
+        target_id = target_node->MyID();
     }
     // subscribe
-    {
-        std::unique_lock<std::shared_mutex> lock(net.spps_lock);
-        net.sp_map[id].insert(target_id);
-        net.ps_map[target_id].insert(id);
-    }
+    int ret = Attach(*target_node, group, policy, filter.get());
+    if (ret != MN_OK) return ret;
     // notify latched when subscribed
-    auto want_trigger_latch = target_node->trigger_latch;
-    auto i_can_recv_latch = event_mask & EVENT_LATCHED;
-    if (want_trigger_latch && i_can_recv_latch) {
-        std::shared_lock<std::shared_mutex> lock(target_node->cache_lock);
+    if (WantsLatched(*target_node)) {
+        LatchSnapshot snap;
+        if (target_node->SnapshotLatched(snap) != MN_OK) {
+            Unsubscribe(target_node);
+            return MN_ERR_NOMEM;
+        }
+        DeliverLatched(target_id, snap);
+    }
+    return MN_OK;
+}
+
+int MycoNode::Attach(MycoNode &target_node, const std::string &group, GroupPolicy policy,
+                     const SubFilter *filter)
+{
+    int ret = group.empty() ? target_node.LinkSubscriber(MyID(), filter) : target_node.JoinGroup(MyID(), group, policy);
+    if (ret != MN_OK) return ret;
+    std::lock_guard<OptMutex> lock(links.lock);
+    links.publishers.insert(target_node.MyID());
+    return MN_OK;
+}
+
+int MycoNode::SnapshotLatched(LatchSnapshot &snap)
+{
+    std::shared_lock<OptSharedMutex> lock(state.lock);
+    // with history the whole ring is replayed, oldest first; before the first
+    // publish the initial cache contents stand in as one sample
+    const uint64_t latest = state.seq;
+    const uint64_t first = latest ? OldestSeq() : 0;
+    snap.length = Length();
+    snap.count = (uint32_t)(latest - first + 1);
+    if (snap.length == 0) return MN_OK;
+    snap.data = net.pool.Alloc(snap.length * snap.count);
+    if (!snap.data) return MN_ERR_NOMEM;
+    for (uint32_t i = 0; i < snap.count; i++)
+        memcpy(snap.data.Data() + i * snap.length, Slot(first + i), snap.length);
+    return MN_OK;
+}
+
+void MycoNode::DeliverLatched(NodeID sender, const LatchSnapshot &snap)
+{
+    for (uint32_t i = 0; i < snap.count; i++) {
         EventParam param = {};
         param.event = EVENT_LATCHED;
-        param.sender = target_id;
-        param.recver = id;
-        param.data_p = static_cast<void *>(target_node->cache.data());
-        param.size = target_node->cache_size;
+        param.sender = sender;
+        param.recver = MyID();
+        param.data_p = snap.length ? const_cast<uint8_t *>(snap.data.Data()) + i * snap.length : nullptr;
+        param.size = snap.length;
         event_cb(&param);
     }
-    return MN_OK;
 }
 
 int MycoNode::Unsubscribe(const std::shared_ptr<MycoNode> &target_node)
 {
-    std::unique_lock<std::shared_mutex> lock(net.spps_lock);
-    net.sp_map[id].erase(target_node->id);
-    net.ps_map[target_node->id].erase(id);
+    target_node->UnlinkSubscriber(MyID());
+    std::lock_guard<OptMutex> lock(links.lock);
+    links.publishers.erase(target_node->MyID());
+    return MN_OK;
+}
+
+std::shared_ptr<const std::vector<NodeID>> MycoNode::Subscribers(std::shared_ptr<const GroupList> *groups,
+                                                                   std::shared_ptr<const FilterTable> *filters)
+{
+    std::lock_guard<OptMutex> lock(links.lock);
+    if (groups) *groups = links.groups;
+    if (filters) *filters = links.filters;
+    return links.subscribers;
+}
+
+int MycoNode::LinkSubscriber(NodeID sub_id, const SubFilter *filter)
+{
+    std::lock_guard<OptMutex> lock(links.lock);
+    if (GroupOf(sub_id)) return MN_ERR_EXIST;
+    const bool linked = links.subscribers &&
+                        std::binary_search(links.subscribers->begin(), links.subscribers->end(), sub_id);
+    if (linked && !filter && !links.filter_of.count(sub_id)) return MN_OK;
+    if (filter) links.filter_of[sub_id] = *filter;
+    else links.filter_of.erase(sub_id);
+    if (!linked) {
+        auto next = links.subscribers ? std::make_shared<std::vector<NodeID>>(*links.subscribers)
+                                      : std::make_shared<std::vector<NodeID>>();
+        next->insert(std::lower_bound(next->begin(), next->end(), sub_id), sub_id);
+        net.Retire(std::move(links.subscribers));
+        links.subscribers = std::move(next);
+    }
+    RebuildFilters();
+    return MN_OK;
+}
+
+void MycoNode::RebuildFilters()
+{
+    // compare outcomes each FilterRule::Op passes, see FilterTable::accept
+    static constexpr uint8_t accept_of[] = {1, 2 | 4, 2, 1 | 2, 4, 1 | 4};
+    if (!links.filters && links.filter_of.empty()) return;
+    std::shared_ptr<FilterTable> next;
+    if (!links.filter_of.empty() && links.subscribers) {
+        const std::vector<NodeID> &list = *links.subscribers;
+        const size_t n = list.size();
+        next = std::make_shared<FilterTable>();
+        next->offset.assign(n, 0);
+        next->width.assign(n, 0);
+        next->accept.assign(n, 1 | 2 | 4);
+        next->mask.assign(n, 0);
+        next->value.assign(n, 0);
+        next->pred.resize(n);
+        for (size_t i = 0; i < n; i++) {
+            auto it = links.filter_of.find(list[i]);
+            if (it == links.filter_of.end()) continue;
+            const SubFilter &filter = it->second;
+            if (filter.has_rule) {
+                next->offset[i] = filter.rule.offset;
+                next->width[i] = filter.rule.width;
+                next->accept[i] = accept_of[filter.rule.op];
+                next->mask[i] = filter.rule.mask;
+                next->value[i] = filter.rule.value;
+            }
+            next->pred[i] = filter.pred;
+        }
+    }
+    net.Retire(std::move(links.filters));
+    links.filters = std::move(next);
+}
+
+// host byte order field of a FilterRule
+static inline uint64_t load_field(const uint8_t *p, uint8_t width)
+{
+    switch (width) {
+    case 1: return *p;
+    case 2: { uint16_t v; memcpy(&v, p, sizeof(v)); return v; }
+    case 4: { uint32_t v; memcpy(&v, p, sizeof(v)); return v; }
+    default: { uint64_t v; memcpy(&v, p, sizeof(v)); return v; }
+    }
+}
+
+size_t FilterTable::Match(const void *buf, size_t size, uint64_t *pass) const
+{
+    const size_t n = width.size();
+    const size_t words = (n + 63) / 64;
+    const uint8_t *bytes = static_cast<const uint8_t *>(buf);
+    // All rules first, 64 subscribers to a word. Besides the field load, the
+    // loop does not branch: the outcome is matched against the accept mask.
+    for (size_t w = 0; w < words; w++) {
+        uint64_t word = 0;
+        const size_t last = std::min(n, w * 64 + 64);
+        for (size_t i = w * 64; i < last; i++) {
+            const bool inside = (size_t)offset[i] + width[i] <= size;
+            const uint64_t field = width[i] && inside ? load_field(bytes + offset[i], width[i]) & mask[i] : 0;
+            const unsigned outcome = (field == value[i]) | (field < value[i]) << 1 | (field > value[i]) << 2;
+            word |= (uint64_t)((outcome & accept[i]) != 0 && inside) << (i - w * 64);
+        }
+        pass[w] = word;
+    }
+    // then the predicates, only where the rule let the sample through
+    size_t kept = 0;
+    for (size_t i = 0; i < n; i++) {
+        uint64_t &word = pass[i / 64];
+        const uint64_t bit = 1ull << (i % 64);
+        if (!(word & bit)) continue;
+        if (pred[i] && !pred[i](buf, size)) word &= ~bit;
+        else kept++;
+    }
+    return kept;
+}
+
+// Per-thread filter bitmaps, one per nesting level of Dispatch (a callback
+// may publish in turn), kept across publishes so filtering does not allocate
+static thread_local std::vector<std::vector<uint64_t>> tls_filter_bits;
+static thread_local size_t tls_filter_depth = 0;
+
+class FilterScratch {
+public:
+    FilterScratch() = default;
+    FilterScratch(const FilterScratch &) = delete;
+    FilterScratch &operator=(const FilterScratch &) = delete;
+    ~FilterScratch() { if (level != SIZE_MAX) tls_filter_depth--; }
+
+    // bitmap for n subscribers, valid until this scratch goes away
+    uint64_t *Bits(size_t n) {
+        level = tls_filter_depth++;
+        if (tls_filter_bits.size() <= level) tls_filter_bits.resize(level + 1);
+        std::vector<uint64_t> &bits = tls_filter_bits[level];
+        if (bits.size() < (n + 63) / 64) bits.resize((n + 63) / 64);
+        return bits.data();
+    }
+
+private:
+    size_t level = SIZE_MAX;
+};
+
+// splitmix64 finalizer
+static inline uint64_t mix64(uint64_t x)
+{
+    x ^= x >> 30;
+    x *= 0xbf58476d1ce4e5b9ull;
+    x ^= x >> 27;
+    x *= 0x94d049bb133111ebull;
+    return x ^ (x >> 31);
+}
+
+// a new version of `group` with `members`, null once nobody is left
+static std::shared_ptr<const ConsumerGroup> make_group(const std::string &name, GroupPolicy policy,
+                                                      std::vector<NodeID> members,
+                                                      std::shared_ptr<std::atomic<uint32_t>> cursor,
+                                                      uint32_t partitions)
+{
+    if (members.empty()) return nullptr;
+    auto group = std::make_shared<ConsumerGroup>();
+    group->name = name;
+    group->policy = policy;
+    group->load.reset(new std::atomic<int>[members.size()]());
+    // rendezvous hashing: each partition goes to the member with the highest
+    // weight for it, which only changes for partitions that member wins or loses
+    group->owner.resize(partitions);
+    for (uint32_t p = 0; p < partitions; p++) {
+        uint64_t best = 0;
+        for (uint32_t m = 0; m < members.size(); m++) {
+            const uint64_t weight = mix64(mix64(p) ^ members[m]);
+            if (m == 0 || weight > best) {
+                best = weight;
+                group->owner[p] = m;
+            }
+        }
+    }
+    group->members = std::move(members);
+    group->cursor = cursor ? std::move(cursor) : std::make_shared<std::atomic<uint32_t>>(0);
+    return group;
+}
+
+const ConsumerGroup *MycoNode::GroupOf(NodeID sub_id) const
+{
+    if (!links.groups) return nullptr;
+    for (const auto &group : *links.groups)
+        if (std::binary_search(group->members.begin(), group->members.end(), sub_id)) return group.get();
+    return nullptr;
+}
+
+int MycoNode::JoinGroup(NodeID sub_id, const std::string &group, GroupPolicy policy)
+{
+    std::lock_guard<OptMutex> lock(links.lock);
+    if (links.subscribers && std::binary_search(links.subscribers->begin(), links.subscribers->end(), sub_id))
+        return MN_ERR_EXIST;
+    if (const ConsumerGroup *current = GroupOf(sub_id))
+        return current->name == group ? MN_OK : MN_ERR_EXIST;
+
+    auto next = links.groups ? std::make_shared<GroupList>(*links.groups) : std::make_shared<GroupList>();
+    auto it = std::find_if(next->begin(), next->end(),
+                           [&](const std::shared_ptr<const ConsumerGroup> &g) { return g->name == group; });
+    if (it == next->end()) {
+        next->push_back(make_group(group, policy, {sub_id}, nullptr, partitions));
+    } else {
+        std::vector<NodeID> members = (*it)->members;
+        members.insert(std::lower_bound(members.begin(), members.end(), sub_id), sub_id);
+        *it = make_group(group, (*it)->policy, std::move(members), (*it)->cursor, partitions);
+    }
+    net.Retire(std::move(links.groups));
+    links.groups = std::move(next);
     return MN_OK;
 }
 
+bool MycoNode::LeaveGroup(NodeID sub_id)
+{
+    const ConsumerGroup *current = GroupOf(sub_id);
+    if (!current) return false;
+    auto next = std::make_shared<GroupList>();
+    for (const auto &group : *links.groups) {
+        if (group.get() != current) {
+            next->push_back(group);
+            continue;
+        }
+        std::vector<NodeID> members = group->members;
+        members.erase(std::lower_bound(members.begin(), members.end(), sub_id));
+        if (auto rest = make_group(group->name, group->policy, std::move(members), group->cursor, partitions))
+            next->push_back(std::move(rest));
+    }
+    net.Retire(std::move(links.groups));
+    if (!next->empty()) links.groups = std::move(next);
+    return true;
+}
+
+void MycoNode::UnlinkSubscriber(NodeID sub_id)
+{
+    std::lock_guard<OptMutex> lock(links.lock);
+    if (LeaveGroup(sub_id)) return;
+    if (!links.subscribers) return;
+    auto pos = std::lower_bound(links.subscribers->begin(), links.subscribers->end(), sub_id);
+    if (pos == links.subscribers->end() || *pos != sub_id) return;
+    auto next = std::make_shared<std::vector<NodeID>>(*links.subscribers);
+    next->erase(next->begin() + (pos - links.subscribers->begin()));
+    net.Retire(std::move(links.subscribers));
+    links.subscribers = std::move(next);
+    links.filter_of.erase(sub_id);
+    RebuildFilters();
+}
+
 int MycoNode::PullAnon(std::string target_node_name, void *buf, size_t size)
+{
+    return PullAnon(MycoNet::Inst(), target_node_name, buf, size);
+}
+
+int MycoNode::PullAnon(MycoNet &net, std::string target_node_name, void *buf, size_t size)
 {
     if (!buf) return MN_ERR_NULL_POINTER;
 
-    auto [target_id, target_node] = MycoNet::Inst().GetNode(target_node_name);
-    if (target_id == INVALID_ID) return MN_ERR_NOTFOUND;
-    if (size != target_node->cache_size) 
+    auto target_node = net.Lookup(target_node_name);
+    if (!target_node) return MN_ERR_NOTFOUND;
+    if (!target_node->SizeOk(size))
         return MN_ERR_SIZE_MISMATCH;
 
     if(target_node->using_cache) {
-        std::shared_lock<std::shared_mutex> lock(target_node->cache_lock);
-        memcpy(buf, target_node->cache.data(), size);
-        return MN_INFO_CACHE_PULLED;
+        std::shared_lock<OptSharedMutex> lock(target_node->state.lock);
+        return target_node->CopyOut(target_node->state.seq, buf, size);
     }
 
     return MN_ERR_NOSUPPORT;
 }
 
-int MycoNode::Pull(const std::shared_ptr<MycoNode> &target_node, void *buf, size_t size)
+int MycoNode::Pull(MycoNode &target_node, void *buf, size_t size, size_t *len)
 {
     if (!buf) return MN_ERR_NULL_POINTER;
     // Check size
-    if (size != target_node->cache_size) return MN_ERR_SIZE_MISMATCH;
+    if (len) *len = target_node.cache_size;
+    if (!target_node.SizeOk(size)) return MN_ERR_SIZE_MISMATCH;
     
     // If target node is using cache, copy data to this node's cache and return
-    if(target_node->using_cache) {
-        std::shared_lock<std::shared_mutex> lock(target_node->cache_lock);
-        memcpy(buf, target_node->cache.data(), size);
-        return MN_INFO_CACHE_PULLED;
+    if(target_node.using_cache) {
+        std::shared_lock<OptSharedMutex> lock(target_node.state.lock);
+        return target_node.CopyOut(target_node.state.seq, buf, size, len);
     }
 
     // Call event callback if registered for PULL events
-    if (target_node->event_mask & EVENT_PULL)
+    if (target_node.event_mask & EVENT_PULL)
     {
         EventParam param = {};
         param.event = EVENT_PULL;
-        param.sender = id;
-        param.recver = target_node->id;
+        param.sender = MyID();
+        param.recver = target_node.MyID();
         param.data_p = buf;
         param.size = size;
-        target_node->event_cb(&param);
+        target_node.event_cb(&param);
     }
 
     return MN_OK;
 }
 
-int MycoNode::Notify(const std::shared_ptr<MycoNode> &target_node, const void *buf, size_t size)
+int MycoNode::PeekSize(MycoNode &target_node, size_t *len)
+{
+    if (!len) return MN_ERR_NULL_POINTER;
+    if (!target_node.using_cache) {
+        *len = target_node.cache_size;
+        return MN_OK;
+    }
+    std::shared_lock<OptSharedMutex> lock(target_node.state.lock);
+    *len = target_node.Length();
+    return MN_OK;
+}
+
+int MycoNode::Pull0(MycoNode &target_node, const std::function<void (const void *data_p, size_t size)> &fn)
+{
+    if (!fn) return MN_ERR_NULL_POINTER;
+    if (!target_node.using_cache) return MN_ERR_NOSUPPORT;
+    std::shared_lock<OptSharedMutex> lock(target_node.state.lock);
+    fn(target_node.Slot(target_node.state.seq), target_node.Length());
+    return MN_INFO_CACHE_PULLED;
+}
+
+int MycoNode::PullNext(MycoNode &target_node, void *buf, size_t size, uint32_t timeout_ms)
+{
+    if (!buf) return MN_ERR_NULL_POINTER;
+    if (!target_node.using_cache) return MN_ERR_NOSUPPORT;
+    if (!target_node.SizeOk(size)) return MN_ERR_SIZE_MISMATCH;
+
+    const NodeID target_id = target_node.MyID();
+    uint64_t last_seq = 0;
+    {
+        std::lock_guard<OptMutex> lock(pulled.lock);
+        auto it = pulled.seen_seq.find(target_id);
+        if (it != pulled.seen_seq.end()) last_seq = it->second;
+    }
+
+    // RemoveNode invalidates the id under state.lock and wakes us up as well
+    auto ready = [&]() {
+        return target_node.state.seq > last_seq || target_node.MyID() == INVALID_ID;
+    };
+
+    std::shared_lock<OptSharedMutex> lock(target_node.state.lock);
+    if (!ready()) {
+        // on a SINGLE instance the only thread that could publish is this one
+        if (timeout_ms == 0 || net.threading == Threading::SINGLE) return MN_ERR_TIMEOUT;
+
+        bool woken = true;
+        target_node.state.waiters.fetch_add(1);
+        if (timeout_ms == MN_WAIT_FOREVER) {
+            target_node.state.cv.wait(lock, ready);
+        } else {
+            woken = target_node.state.cv.wait_for(lock, std::chrono::milliseconds(timeout_ms), ready);
+        }
+        target_node.state.waiters.fetch_sub(1);
+        if (!woken) return MN_ERR_TIMEOUT;
+    }
+    if (target_node.MyID() == INVALID_ID) return MN_ERR_NOTFOUND;
+
+    const int ret = target_node.CopyOut(target_node.state.seq, buf, size);
+    if (ret < 0) return ret;
+    const uint64_t seq = target_node.state.seq;
+    lock.unlock();
+
+    std::lock_guard<OptMutex> seen_lock(pulled.lock);
+    pulled.seen_seq[target_id] = seq;
+    return MN_INFO_CACHE_PULLED;
+}
+
+int MycoNode::PullIfNewer(MycoNode &target_node, uint64_t *last_seq, void *buf, size_t size,
+                          uint32_t max_age_ms, int64_t *stamp_ns)
+{
+    if (!buf || !last_seq) return MN_ERR_NULL_POINTER;
+    if (!target_node.using_cache) return MN_ERR_NOSUPPORT;
+    if (!target_node.SizeOk(size)) return MN_ERR_SIZE_MISMATCH;
+
+    std::shared_lock<OptSharedMutex> lock(target_node.state.lock);
+    const auto &st = target_node.state;
+    if (stamp_ns) *stamp_ns = st.stamp_ns;
+    if (st.seq == 0) return MN_ERR_NODATA;
+    if (st.seq == *last_seq) return MN_INFO_UNCHANGED;
+    if (max_age_ms && steady_now_ns() - st.stamp_ns > (int64_t)max_age_ms * 1000000)
+        return MN_ERR_STALE;
+    const int ret = target_node.CopyOut(st.seq, buf, size);
+    if (ret >= 0) *last_seq = st.seq;
+    return ret;
+}
+
+int MycoNode::PullAt(MycoNode &target_node, uint64_t seq, void *buf, size_t size)
+{
+    if (!buf) return MN_ERR_NULL_POINTER;
+    if (!target_node.using_cache) return MN_ERR_NOSUPPORT;
+    if (!target_node.SizeOk(size)) return MN_ERR_SIZE_MISMATCH;
+
+    std::shared_lock<OptSharedMutex> lock(target_node.state.lock);
+    if (seq == 0 || seq > target_node.state.seq || seq < target_node.OldestSeq())
+        return MN_ERR_NODATA; // not published yet, or overwritten
+    return target_node.CopyOut(seq, buf, size);
+}
+
+int MycoNode::PullRange(MycoNode &target_node, uint64_t from, uint32_t n, void *buf, size_t size,
+                        uint64_t *first_seq, uint32_t *pulled)
+{
+    if (!buf) return MN_ERR_NULL_POINTER;
+    if (!target_node.using_cache || target_node.varsize) return MN_ERR_NOSUPPORT;
+    if (size != target_node.cache_size) return MN_ERR_SIZE_MISMATCH;
+    if (pulled) *pulled = 0;
+
+    std::shared_lock<OptSharedMutex> lock(target_node.state.lock);
+    const uint64_t latest = target_node.state.seq;
+    const uint64_t oldest = target_node.OldestSeq();
+    if (from == 0) from = latest >= n ? latest - n + 1 : 1;
+    if (from < oldest) from = oldest;
+    if (n == 0 || latest == 0 || from > latest) return MN_ERR_NODATA;
+
+    const uint32_t count = (uint32_t)std::min<uint64_t>(n, latest - from + 1);
+    for (uint32_t i = 0; i < count; i++)
+        memcpy(static_cast<uint8_t *>(buf) + i * size, target_node.Slot(from + i), size);
+    if (first_seq) *first_seq = from;
+    if (pulled) *pulled = count;
+    return MN_INFO_CACHE_PULLED;
+}
+
+int MycoNode::PullMany(PullItem *items, size_t n, bool consistent)
+{
+    if (!items) return MN_ERR_NULL_POINTER;
+    std::vector<MycoNet::NodeHold> targets;
+    net.LookupMany(items, n, targets);
+
+    int ret = MN_OK;
+    for (size_t i = 0; i < n; i++) {
+        PullItem &item = items[i];
+        item.seq = 0;
+        if (!targets[i]) {
+            item.status = MN_ERR_NOTFOUND;
+        } else if (!item.buf) {
+            item.status = MN_ERR_NULL_POINTER;
+        } else if (!targets[i]->using_cache) {
+            item.status = consistent ? MN_ERR_NOSUPPORT : Pull(*targets[i], item.buf, item.size);
+        } else if (!targets[i]->SizeOk(item.size)) {
+            item.status = MN_ERR_SIZE_MISMATCH;
+        } else {
+            CacheState &st = targets[i]->state;
+            std::shared_lock<OptSharedMutex> lock(st.lock);
+            item.status = targets[i]->CopyOut(st.seq, item.buf, item.size);
+            item.seq = st.seq;
+        }
+        if (item.status < 0 && ret == MN_OK) ret = item.status;
+    }
+    if (!consistent || ret != MN_OK) return ret;
+
+    // Every sample stayed current from its copy up to its check, so once a
+    // whole pass finds nothing moved, the instant before that pass saw them all.
+    for (uint32_t round = 0; round < MN_CONFIG_PULL_MANY_RETRIES; round++) {
+        bool moved = false;
+        for (size_t i = 0; i < n; i++) {
+            CacheState &st = targets[i]->state;
+            std::shared_lock<OptSharedMutex> lock(st.lock);
+            if (st.seq == items[i].seq) continue;
+            const int status = targets[i]->CopyOut(st.seq, items[i].buf, items[i].size);
+            if (status < 0) return items[i].status = status;
+            items[i].seq = st.seq;
+            moved = true;
+        }
+        if (!moved) return MN_OK;
+    }
+    return MN_ERR_BUSY;
+}
+
+int MycoNode::PullRegion(MycoNode &target_node, size_t offset, void *buf, size_t len)
+{
+    if (!buf) return MN_ERR_NULL_POINTER;
+    if (!target_node.using_cache || target_node.varsize) return MN_ERR_NOSUPPORT;
+    if (len == 0 || offset > target_node.cache_size || len > target_node.cache_size - offset)
+        return MN_ERR_INVALID;
+
+    std::shared_lock<OptSharedMutex> lock(target_node.state.lock);
+    memcpy(buf, target_node.Slot(target_node.state.seq) + offset, len);
+    return MN_INFO_CACHE_PULLED;
+}
+
+int MycoNode::PullDirty(MycoNode &target_node, uint64_t *since, void *buf, size_t size)
+{
+    if (!buf || !since) return MN_ERR_NULL_POINTER;
+    if (!target_node.using_cache || target_node.varsize) return MN_ERR_NOSUPPORT;
+    if (size != target_node.cache_size) return MN_ERR_SIZE_MISMATCH;
+
+    std::shared_lock<OptSharedMutex> lock(target_node.state.lock);
+    const auto &st = target_node.state;
+    if (st.seq <= *since) return MN_ERR_NODATA;
+
+    const uint8_t *src = target_node.Slot(st.seq);
+    uint8_t *dst = static_cast<uint8_t *>(buf);
+    if (*since == 0 || st.full_seq > *since || st.chunk_seq.empty()) {
+        memcpy(dst, src, size);
+    } else {
+        // one memcpy per run of dirty chunks
+        const size_t chunks = st.chunk_seq.size();
+        for (size_t i = 0; i < chunks; ) {
+            if (st.chunk_seq[i] <= *since) { i++; continue; }
+            size_t end = i + 1;
+            while (end < chunks && st.chunk_seq[end] > *since) end++;
+            const size_t from = i * MN_CONFIG_REGION_CHUNK;
+            const size_t to = std::min(end * MN_CONFIG_REGION_CHUNK, size);
+            memcpy(dst + from, src + from, to - from);
+            i = end;
+        }
+    }
+    *since = st.seq;
+    return MN_INFO_CACHE_PULLED;
+}
+
+int MycoNode::Notify(MycoNode &target_node, const void *buf, size_t size)
 {
     if (buf == nullptr) return MN_ERR_NULL_POINTER;
     // check size
-    if (target_node->check_notify_size && size != target_node->notify_size)
+    if (target_node.check_notify_size && size != target_node.notify_size)
     {
         return MN_ERR_SIZE_MISMATCH;
     }
 
     // Call event callback if registered for NOTIFY events
-    if (target_node->event_mask & EVENT_NOTIFY)
+    if (target_node.event_mask & EVENT_NOTIFY)
     {
         EventParam param = {};
         param.event = EVENT_NOTIFY;
-        param.sender = id;
-        param.recver = target_node->id;
+        param.sender = MyID();
+        param.recver = target_node.MyID();
         param.data_p = const_cast<void *>(buf);
         param.size = size;
-        target_node->event_cb(&param);
+        target_node.event_cb(&param);
     }
 
     return MN_OK;
@@ -180,80 +825,622 @@ int MycoNode::Unsubscribe(NodeID target_node_id)
 }
 
 int MycoNode::Publish(const void *buf, size_t size)
+{
+    return DoPublish(buf, size, nullptr);
+}
+
+int MycoNode::Publish(const void *buf, size_t size, uint64_t key)
+{
+    return DoPublish(buf, size, &key);
+}
+
+int MycoNode::DoPublish(const void *buf, size_t size, const uint64_t *key)
 {
     if (buf == nullptr) return MN_ERR_NULL_POINTER;
 
     if (using_cache) {
-        if (size != cache_size) {
+        if (varsize ? size > cache_size : size != cache_size) {
             return MN_ERR_SIZE_MISMATCH;
         }
-        std::unique_lock<std::shared_mutex> lock(cache_lock);
-        memcpy(cache.data(), buf, size);
+        {
+            std::unique_lock<OptSharedMutex> lock(state.lock);
+            int ret = Store(buf, size);
+            if (ret != MN_OK) return ret;
+        }
+        if (state.waiters.load() > 0)
+            state.cv.notify_all();
+    }
+
+    Dispatch(EVENT_PUBLISH, buf, size, 0, key);
+    return MN_OK;
+}
+
+int MycoNode::Store(const void *buf, size_t size)
+{
+    if (state.lent) return MN_ERR_BUSY;
+    if (varsize) {
+        int ret = Grow(size, false);
+        if (ret != MN_OK) return ret;
+        cache.Resize(size);
+    }
+    if (!state.placed) {
+        // untouched pages fault in on the publisher's node from here on
+        MsgPool::BindNode(cache, MsgPool::CurrentNumaNode());
+        state.placed = true;
+    }
+    if (size) memcpy(Slot(state.seq + 1), buf, size);
+    state.full_seq = ++state.seq;
+    state.stamp_ns = steady_now_ns();
+    return MN_OK;
+}
+
+int MycoNode::Grow(size_t size, bool keep)
+{
+    if (size <= cache.Capacity()) return MN_OK;
+    // doubling keeps republishing growing samples cheap, capped at the configured size
+    Buffer grown = MsgPool::AllocPlaced(std::min(cache_size, std::max(size, cache.Capacity() * 2)),
+                                        numa_node, huge_pages);
+    if (!grown) return MN_ERR_NOMEM;
+    const size_t length = cache.Size();
+    if (keep && length) memcpy(grown.Data(), cache.Data(), length);
+    grown.Resize(length);
+    cache = std::move(grown);
+    return MN_OK;
+}
+
+int MycoNode::CopyOut(uint64_t seq, void *buf, size_t size, size_t *len)
+{
+    const size_t length = Length();
+    if (len) *len = length;
+    if (varsize ? size < length : size != length) return MN_ERR_SIZE_MISMATCH;
+    if (length) memcpy(buf, Slot(seq), length);
+    return MN_INFO_CACHE_PULLED;
+}
+
+int MycoNode::Publish(Buffer &&buf, Buffer *prev)
+{
+    if (!buf) return MN_ERR_NULL_POINTER;
+    if (using_cache && (varsize ? buf.Size() > cache_size : buf.Size() != cache_size))
+        return MN_ERR_SIZE_MISMATCH;
+
+    Buffer taken = std::move(buf);
+    const uint8_t *data = taken.Data();
+    const size_t size = taken.Size();
+
+    if (using_cache) {
+        {
+            std::unique_lock<OptSharedMutex> lock(state.lock);
+            if (state.lent) {
+                buf = std::move(taken);
+                return MN_ERR_BUSY;
+            }
+            if (history_depth == 1) {
+                // the slot is the whole cache: take the caller's block in its place,
+                // nobody writes to it until the subscribers below are done with it
+                std::swap(cache, taken);
+                state.lent = true;
+                if (!state.placed) MsgPool::BindNode(cache, MsgPool::CurrentNumaNode());
+            } else {
+                if (!state.placed) MsgPool::BindNode(cache, MsgPool::CurrentNumaNode());
+                memcpy(Slot(state.seq + 1), data, size);
+            }
+            state.placed = true;
+            state.full_seq = ++state.seq;
+            state.stamp_ns = steady_now_ns();
+        }
+        if (state.waiters.load() > 0)
+            state.cv.notify_all();
     }
 
-    // copy subscribers list
-    std::unique_ptr<std::set<NodeID>> subscribers = nullptr;
+    Dispatch(EVENT_PUBLISH, data, size);
+    if (using_cache && history_depth == 1) {
+        std::unique_lock<OptSharedMutex> lock(state.lock);
+        state.lent = false;
+    }
+    if (prev) *prev = std::move(taken);
+    return MN_OK;
+}
+
+int MycoNode::PublishRegion(size_t offset, const void *buf, size_t len)
+{
+    if (buf == nullptr) return MN_ERR_NULL_POINTER;
+    // a history slot holds whole samples, a region alone is not one
+    if (!using_cache || varsize || history_depth > 1) return MN_ERR_NOSUPPORT;
+    if (len == 0 || offset > cache_size || len > cache_size - offset) return MN_ERR_INVALID;
+
     {
-        std::shared_lock<std::shared_mutex> lock(net.spps_lock);
-        auto it = net.ps_map.find(id);
-        if (it == net.ps_map.end()) 
-            return MN_OK; // no subscribers also fine
-        subscribers = std::make_unique<std::set<NodeID>>(it->second);
+        std::unique_lock<OptSharedMutex> lock(state.lock);
+        if (state.lent) return MN_ERR_BUSY;
+        if (!state.placed) {
+            MsgPool::BindNode(cache, MsgPool::CurrentNumaNode());
+            state.placed = true;
+        }
+        memcpy(cache.Data() + offset, buf, len);
+        state.seq++;
+        state.stamp_ns = steady_now_ns();
+        if (state.chunk_seq.empty())
+            state.chunk_seq.assign((cache_size + MN_CONFIG_REGION_CHUNK - 1) / MN_CONFIG_REGION_CHUNK, 0);
+        const size_t last = (offset + len - 1) / MN_CONFIG_REGION_CHUNK;
+        for (size_t i = offset / MN_CONFIG_REGION_CHUNK; i <= last; i++)
+            state.chunk_seq[i] = state.seq;
     }
+    if (state.waiters.load() > 0)
+        state.cv.notify_all();
+
+    Dispatch(EVENT_PUBLISH_REGION, buf, len, (uint32_t)offset);
+    return MN_OK;
+}
+
+void MycoNode::Dispatch(EventCode event, const void *buf, size_t size, uint32_t offset,
+                        const uint64_t *key)
+{
+    // snapshot of the subscribers list, single-threaded instances borrow it
+    MycoNet::Borrow borrow(net);
+    std::shared_ptr<const std::vector<NodeID>> pinned;
+    std::shared_ptr<const GroupList> pinned_groups;
+    std::shared_ptr<const FilterTable> pinned_filters;
+    const std::vector<NodeID> *subscribers;
+    const GroupList *groups;
+    const FilterTable *filters;
+    if (net.threading == Threading::SHARED) {
+        pinned = Subscribers(&pinned_groups, &pinned_filters);
+        subscribers = pinned.get();
+        groups = pinned_groups.get();
+        filters = pinned_filters.get();
+    } else {
+        subscribers = links.subscribers.get();
+        groups = links.groups.get();
+        filters = links.filters.get();
+    }
+    // filtered out subscribers cost neither a callback nor a queued copy
+    size_t receivers = subscribers ? subscribers->size() : 0;
+    const uint64_t *pass = nullptr;
+    FilterScratch scratch;
+    if (receivers && filters) {
+        uint64_t *bits = scratch.Bits(receivers);
+        receivers = filters->Match(buf, size, bits);
+        pass = bits;
+    }
+
+    // no subscribers also fine
+    if (receivers) {
+        if (fanout_threshold && receivers >= fanout_threshold) {
+            DispatchParallel(std::move(pinned), event, buf, size, offset, pass);
+        } else {
+            DispatchRange(net, MyID(), subscribers->data(), subscribers->data() + subscribers->size(),
+                          event, buf, size, offset, pass);
+        }
+    }
+    if (groups)
+        DispatchGroups(*groups, event, buf, size, offset, key);
+}
 
-    for (const auto &sub_id : *subscribers)
+// Add to a group counter and return the old value. Only SHARED instances
+// race on it; a SINGLE one gets by with a plain load and store.
+template <typename T>
+static inline T group_add(std::atomic<T> &counter, T delta, bool shared)
+{
+    if (shared) return counter.fetch_add(delta, std::memory_order_relaxed);
+    const T old = counter.load(std::memory_order_relaxed);
+    counter.store(old + delta, std::memory_order_relaxed);
+    return old;
+}
+
+void MycoNode::DispatchGroups(const GroupList &groups, EventCode event, const void *buf, size_t size,
+                              uint32_t offset, const uint64_t *key)
+{
+    const uint32_t partition = key ? (uint32_t)(mix64(*key) % partitions) : 0;
+    const bool shared = net.threading == Threading::SHARED;
+    for (const auto &group : groups) {
+        const size_t n = group->members.size();
+        // candidates in rotation order from the key's owner, or from the cursor
+        // (LEAST_LOADED: from the idlest member); later ones only stand in
+        const size_t start = key ? group->owner[partition]
+                                 : group_add(*group->cursor, 1u, shared) % n;
+        size_t first = start;
+        if (!key && group->policy == GroupPolicy::LEAST_LOADED) {
+            for (size_t k = 1; k < n; k++) {
+                const size_t idx = (start + k) % n;
+                if (group->load[idx].load(std::memory_order_relaxed) < group->load[first].load(std::memory_order_relaxed))
+                    first = idx;
+            }
+        }
+        for (size_t k = 0; k < n; k++) {
+            const size_t idx = (first + k) % n;
+            auto sub_node = net.Lookup(group->members[idx]);
+            if (!sub_node || !(sub_node->event_mask & event)) continue;
+            EventParam param = {};
+            param.event = event;
+            param.sender = MyID();
+            param.recver = sub_node->MyID();
+            param.data_p = const_cast<void *>(buf);
+            param.size = size;
+            param.offset = offset;
+            group_add(group->load[idx], 1, shared);
+            sub_node->event_cb(&param);
+            group_add(group->load[idx], -1, shared);
+            break;
+        }
+    }
+}
+
+void MycoNode::DispatchRange(MycoNet &net, NodeID sender, const NodeID *first, const NodeID *last,
+                             EventCode event, const void *buf, size_t size, uint32_t offset,
+                             const uint64_t *pass, size_t pass_first)
+{
+    for (const NodeID *sub_id = first; sub_id != last; sub_id++)
     {
-        auto sub_node = net.GetNode(sub_id);
-        if (sub_node && sub_node->event_mask & EVENT_PUBLISH)
+        if (pass) {
+            const size_t i = pass_first + (sub_id - first);
+            if (!(pass[i / 64] >> (i % 64) & 1)) continue;
+        }
+        auto sub_node = net.Lookup(*sub_id);
+        if (sub_node && sub_node->event_mask & event)
         {
             EventParam param = {};
-            param.event = EVENT_PUBLISH;
-            param.sender = id;
+            param.event = event;
+            param.sender = sender;
             param.recver = sub_node->MyID();
             param.data_p = const_cast<void *>(buf);
             param.size = size;
+            param.offset = offset;
             sub_node->event_cb(&param);
         }
     }
+}
 
-    return MN_OK;
+void MycoNode::DispatchParallel(std::shared_ptr<const std::vector<NodeID>> subscribers,
+                                EventCode event, const void *buf, size_t size, uint32_t offset,
+                                const uint64_t *pass)
+{
+    MycoNet::FanoutPool &workers = *net.fanout;
+    MycoNet &inst = net;
+    const NodeID sender = MyID();
+    const NodeID *base = subscribers->data();
+    const size_t n = subscribers->size();
+    const size_t parts = std::min(workers.Workers() + 1, n);
+
+    if (fanout_wait) {
+        // the caller takes the first part itself
+        std::atomic<int> pending{(int)parts - 1};
+        for (size_t p = 1; p < parts; p++) {
+            const NodeID *first = base + n * p / parts;
+            const NodeID *last = base + n * (p + 1) / parts;
+            workers.Submit([&inst, &workers, &pending, sender, base, first, last, event, buf, size, offset, pass]() {
+                DispatchRange(inst, sender, first, last, event, buf, size, offset, pass, first - base);
+                workers.Done(pending);
+            });
+        }
+        DispatchRange(inst, sender, base, base + n / parts, event, buf, size, offset, pass);
+        workers.Wait(pending);
+        return;
+    }
+
+    // the caller's buffer (and filter bitmap) is only valid until Publish
+    // returns, the bitmap rides along behind the payload copy
+    const size_t payload = (size + sizeof(uint64_t) - 1) / sizeof(uint64_t) * sizeof(uint64_t);
+    const size_t words = pass ? (n + 63) / 64 : 0;
+    auto copy = std::make_shared<Buffer>(inst.pool.Alloc(payload + words * sizeof(uint64_t)));
+    if (!*copy) {
+        DispatchRange(inst, sender, base, base + n, event, buf, size, offset, pass);
+        return;
+    }
+    if (size) memcpy(copy->Data(), buf, size);
+    if (words) memcpy(copy->Data() + payload, pass, words * sizeof(uint64_t));
+    for (size_t p = 0; p < parts; p++) {
+        const NodeID *first = base + n * p / parts;
+        const NodeID *last = base + n * (p + 1) / parts;
+        workers.Submit([&inst, subscribers, copy, sender, base, first, last, event, size, offset, payload, words]() {
+            const uint64_t *bits = words ? reinterpret_cast<const uint64_t *>(copy->Data() + payload) : nullptr;
+            DispatchRange(inst, sender, first, last, event, copy->Data(), size, offset, bits, first - base);
+        });
+    }
+}
+
+void MycoNode::DetachCache()
+{
+    std::unique_lock<OptSharedMutex> lock(state.lock);
+    // a lent block is still being read, ~MycoNet detaches it again later
+    if (cache.Standalone() || state.lent) return;
+    Buffer copy = MsgPool::AllocPlaced(cache.Size(), numa_node >= 0 ? numa_node : NUMA_ANY, huge_pages);
+    if (!copy) return;
+    memcpy(copy.Data(), cache.Data(), cache.Size());
+    cache = std::move(copy);
 }
 
 int MycoNode::Pull(NodeID target_node_id, void *buf, size_t size)
 {
-    auto target_node = net.GetNode(target_node_id);
-    if (target_node == nullptr) return MN_ERR_NOTFOUND;
-    return Pull(target_node, buf, size);
+    auto target_node = net.Lookup(target_node_id);
+    if (!target_node) return MN_ERR_NOTFOUND;
+    return Pull(*target_node, buf, size);
 }
 
 int MycoNode::Pull(std::string target_node_name, void *buf, size_t size)
 {
-    auto target_node = net.GetNode(target_node_name);
-    if (target_node.first == INVALID_ID) return MN_ERR_NOTFOUND;
-    return Pull(target_node.second, buf, size);
+    auto target_node = net.Lookup(target_node_name);
+    if (!target_node) return MN_ERR_NOTFOUND;
+    return Pull(*target_node, buf, size);
+}
+
+int MycoNode::PullIfNewer(NodeID target_node_id, uint64_t *last_seq, void *buf, size_t size,
+                          uint32_t max_age_ms, int64_t *stamp_ns)
+{
+    auto target_node = net.Lookup(target_node_id);
+    if (!target_node) return MN_ERR_NOTFOUND;
+    return PullIfNewer(*target_node, last_seq, buf, size, max_age_ms, stamp_ns);
+}
+
+int MycoNode::PullIfNewer(std::string target_node_name, uint64_t *last_seq, void *buf, size_t size,
+                          uint32_t max_age_ms, int64_t *stamp_ns)
+{
+    auto target_node = net.Lookup(target_node_name);
+    if (!target_node) return MN_ERR_NOTFOUND;
+    return PullIfNewer(*target_node, last_seq, buf, size, max_age_ms, stamp_ns);
+}
+
+int MycoNode::Pull(NodeID target_node_id, void *buf, size_t size, size_t *len)
+{
+    auto target_node = net.Lookup(target_node_id);
+    if (!target_node) return MN_ERR_NOTFOUND;
+    return Pull(*target_node, buf, size, len);
+}
+
+int MycoNode::Pull(std::string target_node_name, void *buf, size_t size, size_t *len)
+{
+    auto target_node = net.Lookup(target_node_name);
+    if (!target_node) return MN_ERR_NOTFOUND;
+    return Pull(*target_node, buf, size, len);
+}
+
+int MycoNode::PeekSize(NodeID target_node_id, size_t *len)
+{
+    auto target_node = net.Lookup(target_node_id);
+    if (!target_node) return MN_ERR_NOTFOUND;
+    return PeekSize(*target_node, len);
+}
+
+int MycoNode::PeekSize(std::string target_node_name, size_t *len)
+{
+    auto target_node = net.Lookup(target_node_name);
+    if (!target_node) return MN_ERR_NOTFOUND;
+    return PeekSize(*target_node, len);
+}
+
+int MycoNode::Pull0(NodeID target_node_id, const std::function<void (const void *data_p, size_t size)> &fn)
+{
+    auto target_node = net.Lookup(target_node_id);
+    if (!target_node) return MN_ERR_NOTFOUND;
+    return Pull0(*target_node, fn);
+}
+
+int MycoNode::Pull0(std::string target_node_name, const std::function<void (const void *data_p, size_t size)> &fn)
+{
+    auto target_node = net.Lookup(target_node_name);
+    if (!target_node) return MN_ERR_NOTFOUND;
+    return Pull0(*target_node, fn);
+}
+
+int MycoNode::PullAt(NodeID target_node_id, uint64_t seq, void *buf, size_t size)
+{
+    auto target_node = net.Lookup(target_node_id);
+    if (!target_node) return MN_ERR_NOTFOUND;
+    return PullAt(*target_node, seq, buf, size);
+}
+
+int MycoNode::PullAt(std::string target_node_name, uint64_t seq, void *buf, size_t size)
+{
+    auto target_node = net.Lookup(target_node_name);
+    if (!target_node) return MN_ERR_NOTFOUND;
+    return PullAt(*target_node, seq, buf, size);
+}
+
+int MycoNode::PullRange(NodeID target_node_id, uint64_t from, uint32_t n, void *buf, size_t size,
+                        uint64_t *first_seq, uint32_t *pulled)
+{
+    auto target_node = net.Lookup(target_node_id);
+    if (!target_node) return MN_ERR_NOTFOUND;
+    return PullRange(*target_node, from, n, buf, size, first_seq, pulled);
+}
+
+int MycoNode::PullRange(std::string target_node_name, uint64_t from, uint32_t n, void *buf, size_t size,
+                        uint64_t *first_seq, uint32_t *pulled)
+{
+    auto target_node = net.Lookup(target_node_name);
+    if (!target_node) return MN_ERR_NOTFOUND;
+    return PullRange(*target_node, from, n, buf, size, first_seq, pulled);
+}
+
+int MycoNode::PullRegion(NodeID target_node_id, size_t offset, void *buf, size_t len)
+{
+    auto target_node = net.Lookup(target_node_id);
+    if (!target_node) return MN_ERR_NOTFOUND;
+    return PullRegion(*target_node, offset, buf, len);
+}
+
+int MycoNode::PullRegion(std::string target_node_name, size_t offset, void *buf, size_t len)
+{
+    auto target_node = net.Lookup(target_node_name);
+    if (!target_node) return MN_ERR_NOTFOUND;
+    return PullRegion(*target_node, offset, buf, len);
+}
+
+int MycoNode::PullDirty(NodeID target_node_id, uint64_t *since, void *buf, size_t size)
+{
+    auto target_node = net.Lookup(target_node_id);
+    if (!target_node) return MN_ERR_NOTFOUND;
+    return PullDirty(*target_node, since, buf, size);
+}
+
+int MycoNode::PullDirty(std::string target_node_name, uint64_t *since, void *buf, size_t size)
+{
+    auto target_node = net.Lookup(target_node_name);
+    if (!target_node) return MN_ERR_NOTFOUND;
+    return PullDirty(*target_node, since, buf, size);
+}
+
+int MycoNode::PullNext(NodeID target_node_id, void *buf, size_t size, uint32_t timeout_ms)
+{
+    auto target_node = net.Lookup(target_node_id);
+    if (!target_node) return MN_ERR_NOTFOUND;
+    return PullNext(*target_node, buf, size, timeout_ms);
+}
+
+int MycoNode::PullNext(std::string target_node_name, void *buf, size_t size, uint32_t timeout_ms)
+{
+    auto target_node = net.Lookup(target_node_name);
+    if (!target_node) return MN_ERR_NOTFOUND;
+    return PullNext(*target_node, buf, size, timeout_ms);
 }
 
 int MycoNode::Notify(std::string target_node_name, const void *buf, size_t size)
 {
-    auto target_node = net.GetNode(target_node_name);
-    if (target_node.first == INVALID_ID) return MN_ERR_NOTFOUND;
-    return Notify(target_node.second, buf, size);
+    auto target_node = net.Lookup(target_node_name);
+    if (!target_node) return MN_ERR_NOTFOUND;
+    return Notify(*target_node, buf, size);
 }
 
 int MycoNode::Notify(NodeID target_node_id, const void *buf, size_t size)
 {
-    auto target_node = net.GetNode(target_node_id);
-    if (target_node == nullptr) return MN_ERR_NOTFOUND;
-    return Notify(target_node, buf, size);
+    auto target_node = net.Lookup(target_node_id);
+    if (!target_node) return MN_ERR_NOTFOUND;
+    return Notify(*target_node, buf, size);
+}
+int MycoNode::Request(MycoNode &target_node, const void *buf, size_t size,
+                      RespCbFn resp_cb, uint32_t timeout_ms, uint32_t *corr_id)
+{
+    if (buf == nullptr || resp_cb == nullptr) return MN_ERR_NULL_POINTER;
+    if (target_node.check_notify_size && size != target_node.notify_size)
+        return MN_ERR_SIZE_MISMATCH;
+    if (!(target_node.event_mask & EVENT_REQUEST))
+        return MN_ERR_NOSUPPORT;
+
+    net.RpcPoll(); // frees the slots of overdue requests first
+    uint32_t new_corr_id = net.RpcOpen(MyID(), target_node.MyID(), std::move(resp_cb), timeout_ms);
+    if (new_corr_id == RpcSlot::FREE) return MN_ERR_BUSY;
+    // publish the id before the server sees it, it may reply from inside the callback
+    if (corr_id) *corr_id = new_corr_id;
+
+    EventParam param = {};
+    param.event = EVENT_REQUEST;
+    param.sender = MyID();
+    param.recver = target_node.MyID();
+    param.data_p = const_cast<void *>(buf);
+    param.size = size;
+    param.corr_id = new_corr_id;
+    target_node.event_cb(&param);
+
+    return MN_OK;
+}
+
+int MycoNode::Request(std::string target_node_name, const void *buf, size_t size, RespCbFn resp_cb,
+                      uint32_t timeout_ms, uint32_t *corr_id)
+{
+    auto target_node = net.Lookup(target_node_name);
+    if (!target_node) return MN_ERR_NOTFOUND;
+    return Request(*target_node, buf, size, std::move(resp_cb), timeout_ms, corr_id);
+}
+
+int MycoNode::Request(NodeID target_node_id, const void *buf, size_t size, RespCbFn resp_cb,
+                      uint32_t timeout_ms, uint32_t *corr_id)
+{
+    auto target_node = net.Lookup(target_node_id);
+    if (!target_node) return MN_ERR_NOTFOUND;
+    return Request(*target_node, buf, size, std::move(resp_cb), timeout_ms, corr_id);
 }
+
+int MycoNode::Request(std::string target_node_name, const void *buf, size_t size,
+                      void *resp, size_t resp_size, uint32_t timeout_ms)
+{
+    if (resp == nullptr) return MN_ERR_NULL_POINTER;
+
+    struct Waiter {
+        std::mutex lock;
+        std::condition_variable cv;
+        void *resp;
+        size_t resp_size;
+        bool done;
+        int status;
+    } waiter = {{}, {}, resp, resp_size, false, MN_OK};
+
+    // capture a single pointer so the std::function stays in its small buffer
+    auto on_resp = [w = &waiter](int status, const void *data_p, size_t data_size) {
+        if (status >= 0) {
+            if (data_size == w->resp_size) memcpy(w->resp, data_p, data_size);
+            else status = MN_ERR_SIZE_MISMATCH;
+        }
+        std::lock_guard<std::mutex> lock(w->lock);
+        w->status = status;
+        w->done = true;
+        w->cv.notify_one();
+    };
+
+    uint32_t corr_id = 0;
+    int ret = Request(target_node_name, buf, size, on_resp, timeout_ms, &corr_id);
+    if (ret != MN_OK) return ret;
+
+    std::unique_lock<std::mutex> lock(waiter.lock);
+    auto done = [&waiter]() { return waiter.done; };
+    if (timeout_ms == MN_WAIT_FOREVER) {
+        waiter.cv.wait(lock, done);
+    } else if (!waiter.cv.wait_for(lock, std::chrono::milliseconds(timeout_ms), done)) {
+        lock.unlock();
+        if (net.CancelRequest(corr_id) == MN_OK) return MN_ERR_TIMEOUT;
+        // lost the race against a reply that is being delivered right now
+        lock.lock();
+        waiter.cv.wait(lock, done);
+    }
+    return waiter.status;
+}
+
+int MycoNode::Reply(uint32_t corr_id, const void *buf, size_t size)
+{
+    if (buf == nullptr) return MN_ERR_NULL_POINTER;
+
+    RpcSlot *slot = net.RpcTake(corr_id);
+    if (slot == nullptr) return MN_ERR_NOTFOUND;
+    if (slot->server != MyID()) {
+        const int64_t deadline = slot->deadline_ns.load(std::memory_order_relaxed);
+        slot->tag.store(corr_id, std::memory_order_release);
+        net.RpcWatch(deadline); // a concurrent expiry pass skipped it while taken
+        return MN_ERR_ACCESS;
+    }
+
+    const bool expired = steady_now_ns() > slot->deadline_ns.load(std::memory_order_relaxed);
+    RespCbFn resp_cb = std::move(slot->resp_cb);
+    net.RpcRelease(slot);
+
+    int ret = MN_OK;
+    if (expired) {
+        resp_cb(MN_ERR_TIMEOUT, nullptr, 0);
+        ret = MN_ERR_TIMEOUT;
+    } else {
+        resp_cb(MN_OK, buf, size);
+    }
+    net.RpcPoll();
+    return ret;
+}
+
+Buffer MycoNode::Loan(size_t size)
+{
+    if (numa_node != NUMA_ANY || huge_pages) {
+        // loans become cache contents, keep them where the cache lives
+        int node = numa_node == NUMA_PUBLISHER ? MsgPool::CurrentNumaNode() : numa_node;
+        return MsgPool::AllocPlaced(size ? size : cache_size, node, huge_pages);
+    }
+    return net.pool.Alloc(size ? size : cache_size);
+}
+
 int MycoNode::SubNum() {
-    std::shared_lock<std::shared_mutex> lock(net.spps_lock);
-    return net.ps_map[id].size();
+    std::lock_guard<OptMutex> lock(links.lock);
+    size_t num = links.subscribers ? links.subscribers->size() : 0;
+    if (links.groups)
+        for (const auto &group : *links.groups) num += group->members.size();
+    return (int)num;
 }
 
 int MycoNode::PubNum() {
-    std::shared_lock<std::shared_mutex> lock(net.spps_lock);
-    return net.sp_map[id].size();
+    std::lock_guard<OptMutex> lock(links.lock);
+    return links.publishers.size();
 }
 
 // =====================================================
@@ -262,6 +1449,166 @@ int MycoNode::PubNum() {
 // =====================================================
 // =====================================================
 
+MycoNet::MycoNet(Threading threading) :
+    node_count(0), next_id(1), rpc_cursor(0), threading(threading)
+{
+    const bool locked = threading == Threading::SHARED;
+    for (auto &shard : id_shards) shard.lock.enabled = locked;
+    for (auto &shard : name_shards) shard.lock.enabled = locked;
+}
+
+int MycoNet::StartFanout(unsigned threads)
+{
+    if (threading == Threading::SINGLE) return MN_ERR_NOSUPPORT;
+    std::lock_guard<std::mutex> lock(fanout_lock);
+    if (fanout) return MN_ERR_INITIALIZED;
+    if (threads == 0) threads = MN_CONFIG_FANOUT_THREADS;
+    if (threads == 0) {
+        const unsigned cores = std::thread::hardware_concurrency();
+        threads = cores > 1 ? cores - 1 : 1;
+    }
+    fanout.reset(new FanoutPool(threads));
+    return MN_OK;
+}
+
+MycoNet::~MycoNet()
+{
+    // queued fan-out jobs still deliver from pool buffers
+    fanout.reset();
+    // nodes still referenced elsewhere outlive the pool, which goes first
+    for (auto &shard : id_shards) {
+        for (auto &pair : shard.nodes) pair.second->DetachCache();
+    }
+}
+
+int MycoNet::Transaction::Publish(const std::shared_ptr<MycoNode> &node, const void *buf, size_t size)
+{
+    if (!node || !buf) return MN_ERR_NULL_POINTER;
+    if (&node->net != &net) return MN_ERR_INVALID;
+    if (node->using_cache && (node->varsize ? size > node->cache_size : size != node->cache_size))
+        return MN_ERR_SIZE_MISMATCH;
+
+    Buffer data = net.pool.Alloc(size);
+    if (!data && size > 0) return MN_ERR_NOMEM;
+    memcpy(data.Data(), buf, size);
+    for (auto &item : staged) {
+        if (item.node != node) continue;
+        item.data = std::move(data);
+        return MN_OK;
+    }
+    staged.push_back({node, std::move(data)});
+    return MN_OK;
+}
+
+int MycoNet::Transaction::Commit()
+{
+    for (auto &item : staged)
+        if (item.node->MyID() == INVALID_ID) return MN_ERR_NOTFOUND;
+
+    // a fixed lock order keeps concurrent commits from deadlocking
+    std::sort(staged.begin(), staged.end(),
+              [](const Staged &a, const Staged &b) { return a.node.get() < b.node.get(); });
+    {
+        std::vector<std::unique_lock<OptSharedMutex>> locks;
+        locks.reserve(staged.size());
+        for (auto &item : staged)
+            if (item.node->using_cache) locks.emplace_back(item.node->state.lock);
+        // the only steps that can fail, done before any cache changes
+        for (auto &item : staged)
+            if (item.node->state.lent) return MN_ERR_BUSY;
+        for (auto &item : staged)
+            if (item.node->varsize && item.node->Grow(item.data.Size(), true) != MN_OK) return MN_ERR_NOMEM;
+        for (auto &item : staged)
+            if (item.node->using_cache) item.node->Store(item.data.Data(), item.data.Size());
+    }
+    for (auto &item : staged)
+        if (item.node->state.waiters.load() > 0) item.node->state.cv.notify_all();
+
+    // every subscriber is looked up once and gets its events back to back
+    std::vector<std::shared_ptr<const std::vector<NodeID>>> lists(staged.size());
+    std::vector<std::shared_ptr<const GroupList>> groups(staged.size());
+    std::vector<NodeID> subscribers;
+    for (size_t i = 0; i < staged.size(); i++) {
+        std::shared_ptr<const FilterTable> filters;
+        lists[i] = staged[i].node->Subscribers(&groups[i], &filters);
+        if (lists[i] && filters) {
+            const std::vector<NodeID> &all = *lists[i];
+            std::vector<uint64_t> pass((all.size() + 63) / 64);
+            filters->Match(staged[i].data.Data(), staged[i].data.Size(), pass.data());
+            auto kept = std::make_shared<std::vector<NodeID>>();
+            for (size_t k = 0; k < all.size(); k++)
+                if (pass[k / 64] >> (k % 64) & 1) kept->push_back(all[k]);
+            lists[i] = std::move(kept);
+        }
+        if (lists[i]) subscribers.insert(subscribers.end(), lists[i]->begin(), lists[i]->end());
+    }
+    std::sort(subscribers.begin(), subscribers.end());
+    subscribers.erase(std::unique(subscribers.begin(), subscribers.end()), subscribers.end());
+
+    for (NodeID sub_id : subscribers) {
+        auto sub_node = net.Lookup(sub_id);
+        if (!sub_node || !(sub_node->event_mask & EVENT_PUBLISH)) continue;
+        for (size_t i = 0; i < staged.size(); i++) {
+            if (!lists[i] || !std::binary_search(lists[i]->begin(), lists[i]->end(), sub_id)) continue;
+            EventParam param = {};
+            param.event = EVENT_PUBLISH;
+            param.sender = staged[i].node->MyID();
+            param.recver = sub_id;
+            param.data_p = staged[i].data.Data();
+            param.size = staged[i].data.Size();
+            sub_node->event_cb(&param);
+        }
+    }
+    // then one member of each consumer group
+    for (size_t i = 0; i < staged.size(); i++)
+        if (groups[i]) staged[i].node->DispatchGroups(*groups[i], EVENT_PUBLISH, staged[i].data.Data(), staged[i].data.Size());
+    staged.clear();
+    return MN_OK;
+}
+
+MycoNet::NodeHold MycoNet::Lookup(NodeID node_id)
+{
+    NodeHold hold(*this);
+    IdShard &shard = IdShardOf(node_id);
+    std::shared_lock<OptSharedMutex> lock(shard.lock);
+    auto it = shard.nodes.find(node_id);
+    if (it == shard.nodes.end() || it->second->MyID() == INVALID_ID) return hold;
+    hold.node = it->second.get();
+    if (threading == Threading::SHARED) hold.owner = it->second;
+    return hold;
+}
+
+MycoNet::NodeHold MycoNet::Lookup(const std::string &node_name)
+{
+    NodeHold hold(*this);
+    NameShard &shard = NameShardOf(node_name);
+    std::shared_lock<OptSharedMutex> lock(shard.lock);
+    auto it = shard.nodes.find(node_name);
+    if (it == shard.nodes.end() || it->second->MyID() == INVALID_ID) return hold;
+    hold.node = it->second.get();
+    if (threading == Threading::SHARED) hold.owner = it->second;
+    return hold;
+}
+
+void MycoNet::LookupMany(const PullItem *items, size_t n, std::vector<NodeHold> &holds)
+{
+    holds.clear();
+    holds.reserve(n);
+    for (size_t i = 0; i < n; i++) holds.emplace_back(*this);
+
+    for (IdShard &shard : id_shards) {
+        std::shared_lock<OptSharedMutex> lock(shard.lock, std::defer_lock);
+        for (size_t i = 0; i < n; i++) {
+            if (&IdShardOf(items[i].target) != &shard) continue;
+            if (!lock.owns_lock()) lock.lock();
+            auto it = shard.nodes.find(items[i].target);
+            if (it == shard.nodes.end() || it->second->MyID() == INVALID_ID) continue;
+            holds[i].node = it->second.get();
+            if (threading == Threading::SHARED) holds[i].owner = it->second;
+        }
+    }
+}
+
 std::shared_ptr<MycoNode> MycoNet::NewNode(std::string node_name, const NodeParam &param)
 {
     // enable std::make_shared to use private constructor
@@ -270,108 +1617,262 @@ std::shared_ptr<MycoNode> MycoNet::NewNode(std::string node_name, const NodePara
             MycoNode(node_name, param, net){}
     };
 
+    NodeID node_id = INVALID_ID;
+    if (node_name.empty()) {
+        node_id = MakeNewNodeId();
+        node_name = "__anonym_node__" + std::to_string(node_id);
+    }
+
+    // workers exist before any node that may hand them callbacks
+    if (param.fanout_threshold > 0 && threading == Threading::SHARED) StartFanout();
+
     std::shared_ptr<MycoNode> new_node;
+    std::list<PendingItem> items_to_process;
     {
-        std::unique_lock<std::shared_mutex> lock(nodes_mutex);
-        if (!node_name.empty() && nodes_map.find(node_name) != nodes_map.end())
+        NameShard &names = NameShardOf(node_name);
+        std::unique_lock<OptSharedMutex> name_lock(names.lock);
+        if (names.nodes.find(node_name) != names.nodes.end())
             return nullptr;
 
-        NodeID node_id = MakeNewNodeId();
-        if (node_name.empty()) {
-            node_name = "__anonym_node__" + std::to_string(node_id);
-        }
+        if (node_id == INVALID_ID) node_id = MakeNewNodeId();
         new_node = std::make_shared<MakeNewNodeEnable>(node_name, param, *this);
-        new_node->id = node_id;
-        nodes[node_id] = new_node;
-        nodes_map[new_node->node_name] = node_id;
-    }
+        // let the pool carry exact-fit classes for the payload sizes we will see
+        if (param.size > 0) pool.AddClass(param.size);
+        if (param.notify_size > 0) pool.AddClass(param.notify_size);
+        new_node->id.store(node_id, std::memory_order_release);
+        {
+            IdShard &ids = IdShardOf(node_id);
+            std::unique_lock<OptSharedMutex> id_lock(ids.lock);
+            ids.nodes[node_id] = new_node;
+        }
+        names.nodes[node_name] = new_node;
+        node_count++;
 
-    // check pending list & add to items_to_process
-    std::list<PendingItem> items_to_process;
-    {
-        std::lock_guard<std::mutex> lock(pending_list_mutex);
-        for (auto it = pending_list.begin(); it != pending_list.end();) {
-            if (it->target_node_name == node_name) {
-                items_to_process.push_back(std::move(*it));
-                it = pending_list.erase(it);
-            } else {
-                ++it;
-            }
+        // check pending list & add to items_to_process
+        for (auto it = names.pending.begin(); it != names.pending.end();) {
+            auto next = std::next(it);
+            if (it->target_node_name == node_name)
+                items_to_process.splice(items_to_process.end(), names.pending, it);
+            it = next;
         }
     }
-    // process items_to_process
+    // process items_to_process: link them all, then replay one shared snapshot
+    std::vector<std::shared_ptr<MycoNode>> latched;
     for (const auto &item : items_to_process)
     {
         auto subscriber_node = GetNode(item.node_id);
-        if (subscriber_node) {
-            subscriber_node->Subscribe(node_name);
-        }
+        if (!subscriber_node) continue;
+        if (subscriber_node->Attach(*new_node, item.group, item.policy, item.filter.get()) != MN_OK) continue;
+        if (subscriber_node->WantsLatched(*new_node)) latched.push_back(std::move(subscriber_node));
+    }
+    if (!latched.empty()) {
+        MycoNode::LatchSnapshot snap;
+        if (new_node->SnapshotLatched(snap) == MN_OK)
+            for (auto &subscriber_node : latched) subscriber_node->DeliverLatched(node_id, snap);
     }
     return new_node;
 }
 
 int MycoNet::RemoveNode(std::string node_name)
 {
-    NodeID node_id;
-    {
-        std::shared_lock<std::shared_mutex> lock(nodes_mutex);
-        auto it = nodes_map.find(node_name);
-        if (it == nodes_map.end()) return MN_ERR_NOTFOUND;
-        node_id = it->second;
-    }
-    
+    NodeID node_id = NodeExists(node_name);
+    if (node_id == INVALID_ID) return MN_ERR_NOTFOUND;
     return RemoveNode(node_id);
 }
 
 int MycoNet::RemoveNode(NodeID node_id)
 {
-    std::unique_lock<std::shared_mutex> nodes_lock(nodes_mutex);
-    auto it = nodes.find(node_id);
-    if (it == nodes.end()) return MN_ERR_NOTFOUND;
-    
-    std::shared_ptr<MycoNode> node_p = it->second;
-    std::string node_name = node_p->node_name;
+    std::shared_ptr<MycoNode> node_p = GetNode(node_id);
+    if (node_p == nullptr) return MN_ERR_NOTFOUND;
 
-    // Mark node as invalid before cleaning up subscriptions
-    node_p->id = INVALID_ID;
+    // step1: unregister, so no lookup hands the node out any more
+    {
+        NameShard &names = NameShardOf(node_p->node_name);
+        std::unique_lock<OptSharedMutex> name_lock(names.lock);
+        IdShard &ids = IdShardOf(node_id);
+        std::unique_lock<OptSharedMutex> id_lock(ids.lock);
+        auto it = ids.nodes.find(node_id);
+        if (it == ids.nodes.end() || it->second != node_p) return MN_ERR_NOTFOUND; // lost a race
+        ids.nodes.erase(it);
+        names.nodes.erase(node_p->node_name);
+        node_count--;
+    }
 
-    // step1: remove sub/pub relations
+    // Mark node as invalid before cleaning up subscriptions,
+    // and kick any PullNext waiters so they see the removal
     {
-        std::unique_lock<std::shared_mutex> lock(spps_lock);
-        
-        // Remove this node from all subscription maps
-        ps_map.erase(node_id);
-        sp_map.erase(node_id);
-        
-        // Remove this node_id from all other nodes' maps
-        for (auto& pair : ps_map) {
-            pair.second.erase(node_id);
-        }
-        for (auto& pair : sp_map) {
-            pair.second.erase(node_id);
+        std::unique_lock<OptSharedMutex> lock(node_p->state.lock);
+        node_p->id.store(INVALID_ID, std::memory_order_release);
+    }
+    node_p->state.cv.notify_all();
+    node_p->DetachCache();
+
+    // step2: remove sub/pub relations, one neighbour lock at a time
+    std::shared_ptr<const std::vector<NodeID>> subscribers;
+    std::shared_ptr<const GroupList> groups;
+    std::shared_ptr<const FilterTable> filters;
+    std::set<NodeID> publishers;
+    {
+        std::lock_guard<OptMutex> lock(node_p->links.lock);
+        subscribers.swap(node_p->links.subscribers);
+        groups.swap(node_p->links.groups);
+        filters.swap(node_p->links.filters);
+        node_p->links.filter_of.clear();
+        publishers.swap(node_p->links.publishers);
+    }
+    std::vector<NodeID> followers;
+    if (subscribers) followers = *subscribers;
+    if (groups)
+        for (const auto &group : *groups)
+            followers.insert(followers.end(), group->members.begin(), group->members.end());
+    for (NodeID pub_id : publishers) {
+        auto pub_node = GetNode(pub_id);
+        if (pub_node) pub_node->UnlinkSubscriber(node_id);
+    }
+    for (NodeID sub_id : followers) {
+        auto sub_node = GetNode(sub_id);
+        if (sub_node == nullptr) continue;
+        std::lock_guard<OptMutex> lock(sub_node->links.lock);
+        sub_node->links.publishers.erase(node_id);
+    }
+
+    Retire(std::move(subscribers));
+    Retire(std::move(groups));
+    Retire(std::move(filters));
+    Retire(std::move(node_p));
+    return MN_OK;
+}
+
+int MycoNet::ReservePool(size_t count)
+{
+    for (auto &shard : id_shards) {
+        std::shared_lock<OptSharedMutex> lock(shard.lock);
+        for (const auto &pair : shard.nodes) {
+            const auto &node = pair.second;
+            int ret = MN_OK;
+            if (node->cache_size > 0 && (ret = pool.Reserve(node->cache_size, count)) != MN_OK) return ret;
+            if (node->notify_size > 0 && (ret = pool.Reserve(node->notify_size, count)) != MN_OK) return ret;
         }
     }
+    return MN_OK;
+}
+
+uint32_t MycoNet::RpcOpen(NodeID client, NodeID server, RespCbFn resp_cb, uint32_t timeout_ms)
+{
+    const uint32_t start = rpc_cursor.fetch_add(1, std::memory_order_relaxed);
+    for (uint32_t i = 0; i < MN_CONFIG_RPC_SLOTS; i++) {
+        const uint32_t index = (start + i) & RPC_INDEX_MASK;
+        RpcSlot &slot = rpc_slots[index];
+
+        uint32_t expected = RpcSlot::FREE;
+        if (!slot.tag.compare_exchange_strong(expected, RpcSlot::BUSY, std::memory_order_acquire))
+            continue;
 
-    // step2: remove node from nodes maps
-    nodes_map.erase(node_name);
-    nodes.erase(node_id);
+        // the round keeps corr_ids of a reused slot apart, and never yields FREE/BUSY
+        slot.round = (slot.round + 1) & (UINT32_MAX >> RPC_INDEX_BITS);
+        if (slot.round == 0) slot.round = 1;
+        slot.client = client;
+        slot.server = server;
+        slot.resp_cb = std::move(resp_cb);
+        const int64_t deadline = timeout_ms == MN_WAIT_FOREVER ?
+            INT64_MAX : steady_now_ns() + int64_t(timeout_ms) * 1000000;
+        slot.deadline_ns.store(deadline, std::memory_order_relaxed);
 
+        const uint32_t corr_id = (slot.round << RPC_INDEX_BITS) | index;
+        slot.tag.store(corr_id, std::memory_order_release);
+        RpcWatch(deadline);
+        return corr_id;
+    }
+    return RpcSlot::FREE;
+}
+
+RpcSlot *MycoNet::RpcTake(uint32_t corr_id)
+{
+    if (corr_id <= RpcSlot::BUSY) return nullptr;
+    RpcSlot &slot = rpc_slots[corr_id & RPC_INDEX_MASK];
+    uint32_t expected = corr_id;
+    if (!slot.tag.compare_exchange_strong(expected, RpcSlot::BUSY, std::memory_order_acquire))
+        return nullptr;
+    return &slot;
+}
+
+void MycoNet::RpcRelease(RpcSlot *slot)
+{
+    slot->resp_cb = nullptr;
+    slot->tag.store(RpcSlot::FREE, std::memory_order_release);
+}
+
+int MycoNet::CancelRequest(uint32_t corr_id)
+{
+    RpcSlot *slot = RpcTake(corr_id);
+    if (slot == nullptr) return MN_ERR_NOTFOUND;
+    RpcRelease(slot);
     return MN_OK;
 }
 
-std::shared_ptr<MycoNet> MycoNet::GetInst(const std::string &name)
+// Lower rpc_due_ns to `deadline_ns`, after the slot's tag is stored. Every write
+// to the mark is a read-modify-write, even when it is already earlier, so an
+// expiry pass that resets it afterwards also sees that tag.
+void MycoNet::RpcWatch(int64_t deadline_ns)
+{
+    if (deadline_ns == INT64_MAX) return;
+    int64_t due = rpc_due_ns.load();
+    while (!rpc_due_ns.compare_exchange_weak(due, std::min(due, deadline_ns))) {}
+}
+
+void MycoNet::RpcPoll()
+{
+    int64_t due = rpc_due_ns.load(std::memory_order_relaxed);
+    if (due == INT64_MAX) return; // nothing with a timeout, skip the clock read
+    const int64_t now = steady_now_ns();
+    // one caller wins the pass, the others go on with their own call
+    if (now < due || !rpc_due_ns.compare_exchange_strong(due, INT64_MAX)) return;
+    RpcExpire(now);
+}
+
+int MycoNet::ExpireRequests()
+{
+    rpc_due_ns.exchange(INT64_MAX);
+    return RpcExpire(steady_now_ns());
+}
+
+// rpc_due_ns was reset, every request left pending puts its deadline back
+int MycoNet::RpcExpire(int64_t now)
+{
+    int expired = 0;
+    for (auto &slot : rpc_slots) {
+        uint32_t corr_id = slot.tag.load(std::memory_order_acquire);
+        if (corr_id <= RpcSlot::BUSY) continue;
+        const int64_t deadline = slot.deadline_ns.load(std::memory_order_relaxed);
+        if (deadline >= now) {
+            RpcWatch(deadline);
+            continue;
+        }
+        if (RpcTake(corr_id) == nullptr) continue; // replied or cancelled meanwhile
+
+        RespCbFn resp_cb = std::move(slot.resp_cb);
+        RpcRelease(&slot);
+        resp_cb(MN_ERR_TIMEOUT, nullptr, 0);
+        expired++;
+    }
+    return expired;
+}
+
+std::shared_ptr<MycoNet> MycoNet::GetInst(const std::string &name, Threading threading)
 {
     std::lock_guard<std::mutex> lock(insts_mutex);
     auto it = insts.find(name);
     if (it != insts.end()) return it->second;
 
-    auto new_net = std::make_shared<MycoNet>();
+    auto new_net = std::make_shared<MycoNet>(threading);
     insts[name] = new_net;
+    if (name == "default") default_inst.store(new_net.get(), std::memory_order_release);
     return new_net;
 }
 
 void MycoNet::DelInst(const std::string &name)
 {
     std::lock_guard<std::mutex> lock(insts_mutex);
+    if (name == "default") default_inst.store(nullptr, std::memory_order_release);
     insts.erase(name);
 }
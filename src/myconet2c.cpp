@@ -3,6 +3,65 @@
 
 using namespace MycoNets;
 
+// Last node resolved by this thread. A hit skips the registry lock; the entry
+// does not keep the node alive, a removed one fails lock() or its ID check.
+struct LastNode {
+    uint64_t net_serial = 0;
+    MycoNet_ID_t id = INVALID_ID;
+    std::weak_ptr<MycoNode> node;
+};
+static thread_local LastNode last_node;
+
+class NodeRef {
+public:
+    NodeRef(MycoNet &net, MycoNet_ID_t id) {
+        LastNode &last = last_node;
+        if (last.id == id && last.net_serial == net.Serial()) {
+            node = last.node.lock();
+            if (node && node->MyID() == id) return;
+        }
+        node = net.GetNode(id);
+        if (node == nullptr) {
+            last = LastNode{};
+            return;
+        }
+        last.node = node;
+        last.id = id;
+        last.net_serial = net.Serial();
+    }
+    NodeRef(const NodeRef &) = delete;
+    NodeRef &operator=(const NodeRef &) = delete;
+
+    MycoNode *operator->() const { return node.get(); }
+    explicit operator bool() const { return node != nullptr; }
+
+private:
+    std::shared_ptr<MycoNode> node; // keeps the node alive while a call runs on it
+};
+
+struct myconet_ctx {
+    std::string name;
+    std::shared_ptr<MycoNet> net;
+};
+
+struct myconet_node {
+    std::shared_ptr<MycoNet> net; // MycoNode only refers to its instance, keep it alive too
+    std::shared_ptr<MycoNode> node;
+};
+
+// NULL selects the default instance
+static inline MycoNet &net_of(myconet_ctx_t *ctx)
+{
+    return ctx ? *ctx->net : MycoNet::Inst();
+}
+
+// handle target, or nullptr once the node has been removed
+static MycoNode *handle_node(const myconet_node_t *handle)
+{
+    MycoNode *node = handle->node.get();
+    return node->MyID() != INVALID_ID ? node : nullptr;
+}
+
 extern "C" {
 MN_API int myconet_init()
 {
@@ -18,19 +77,46 @@ MN_API void myconet_deinit()
 }
 
 
-MN_API int myconet_node_num()
+MN_API const char* myconet_strerr(int err)
 {
-    return MycoNet::Inst().NodeNum();
+    return MycoNet::StrErrCode(err);
 }
 
 
-MN_API const char* myconet_strerr(int err)
+MN_API myconet_ctx_t *myconet_ctx_open(const char *name)
 {
-    return MycoNet::StrErrCode(err);
+    std::string inst_name = name == nullptr ? "default" : name;
+    auto net = MycoNet::GetInst(inst_name);
+    if (net == nullptr) return nullptr;
+    return new myconet_ctx{inst_name, std::move(net)};
 }
 
 
-MN_API int myconet_create_node(MycoNet_ID_t *id, const char *name, const MycoNet_NodeParam_t *conf)
+MN_API void myconet_ctx_close(myconet_ctx_t *ctx)
+{
+    delete ctx;
+}
+
+
+MN_API void myconet_ctx_deinit(myconet_ctx_t *ctx)
+{
+    MycoNet::DelInst(ctx ? ctx->name : "default");
+}
+
+
+MN_API int myconet_ctx_reserve_pool(myconet_ctx_t *ctx, size_t count)
+{
+    return net_of(ctx).ReservePool(count);
+}
+
+
+MN_API int myconet_ctx_node_num(myconet_ctx_t *ctx)
+{
+    return net_of(ctx).NodeNum();
+}
+
+
+MN_API int myconet_ctx_create_node(myconet_ctx_t *ctx, MycoNet_ID_t *id, const char *name, const MycoNet_NodeParam_t *conf)
 {
     if (!id || !conf) return MN_ERR_NULL_POINTER;
     
@@ -43,7 +129,7 @@ MN_API int myconet_create_node(MycoNet_ID_t *id, const char *name, const MycoNet
     param.notify_size = conf->notify_size;
     
     std::string node_name = name == nullptr ? "" : name;
-    auto new_node = MycoNet::Inst().NewNode(node_name, param);
+    auto new_node = net_of(ctx).NewNode(node_name, param);
     if (new_node == nullptr) {
         *id = INVALID_ID;
         return MN_ERR_FAIL;
@@ -53,105 +139,371 @@ MN_API int myconet_create_node(MycoNet_ID_t *id, const char *name, const MycoNet
 }
 
 
-MN_API int myconet_remove_node_id(MycoNet_ID_t id)
+MN_API int myconet_ctx_remove_node_id(myconet_ctx_t *ctx, MycoNet_ID_t id)
 {
-    return MycoNet::Inst().RemoveNode(id);
+    return net_of(ctx).RemoveNode(id);
 }
 
 
-MN_API int myconet_remove_node_name(const char *name)
+MN_API int myconet_ctx_remove_node_name(myconet_ctx_t *ctx, const char *name)
 {
-    NodeID id = MycoNet::Inst().NodeExists(name);
+    if (name == nullptr) return MN_ERR_NULL_POINTER;
+    MycoNet &net = net_of(ctx);
+    NodeID id = net.NodeExists(name);
     if (id == INVALID_ID) return MN_ERR_NOTFOUND;
-    return MycoNet::Inst().RemoveNode(name);
+    return net.RemoveNode(id);
 }
 
 
-MN_API int myconet_subscribe(MycoNet_ID_t id, const char *target_node_name)
+MN_API int myconet_ctx_subscribe(myconet_ctx_t *ctx, MycoNet_ID_t id, const char *target_node_name)
 {
     if (target_node_name == nullptr) return MN_ERR_NULL_POINTER;
-    auto node = MycoNet::Inst().GetNode(id);
-    if (node == nullptr) return MN_ERR_NOTFOUND;
+    NodeRef node(net_of(ctx), id);
+    if (!node) return MN_ERR_NOTFOUND;
     return node->Subscribe(target_node_name);
 }
 
 
-MN_API int myconet_unsubscribe(MycoNet_ID_t id, const char *target_node_name)
+MN_API int myconet_ctx_unsubscribe(myconet_ctx_t *ctx, MycoNet_ID_t id, const char *target_node_name)
 {
     if (target_node_name == nullptr) return MN_ERR_NULL_POINTER;
-    auto node = MycoNet::Inst().GetNode(id);
-    if (node == nullptr) return MN_ERR_NOTFOUND;
+    NodeRef node(net_of(ctx), id);
+    if (!node) return MN_ERR_NOTFOUND;
     return node->Unsubscribe(target_node_name);
 }
 
 
-MN_API int myconet_unsubscribe_id(MycoNet_ID_t id, MycoNet_ID_t target_node_id)
+MN_API int myconet_ctx_unsubscribe_id(myconet_ctx_t *ctx, MycoNet_ID_t id, MycoNet_ID_t target_node_id)
 {
-    auto node = MycoNet::Inst().GetNode(id);
-    auto target_node = MycoNet::Inst().GetNode(target_node_id);
-    if (node == nullptr || target_node == nullptr) return MN_ERR_NOTFOUND;
+    MycoNet &net = net_of(ctx);
+    NodeRef node(net, id);
+    if (!node || !net.NodeExists(target_node_id)) return MN_ERR_NOTFOUND;
     return node->Unsubscribe(target_node_id);
 }
 
 
-MN_API int myconet_publish(MycoNet_ID_t id, const void *data_p, size_t size)
+MN_API int myconet_ctx_publish(myconet_ctx_t *ctx, MycoNet_ID_t id, const void *data_p, size_t size)
 {
-    auto node = MycoNet::Inst().GetNode(id);
-    if (node == nullptr) return MN_ERR_NOTFOUND;
+    NodeRef node(net_of(ctx), id);
+    if (!node) return MN_ERR_NOTFOUND;
     return node->Publish(data_p, size);
 }
 
 
-MN_API int myconet_pull(MycoNet_ID_t id, const char *target_node_name, void *data_p, size_t size)
+MN_API int myconet_ctx_pull_anon(myconet_ctx_t *ctx, const char *target_node_name, void *data_p, size_t size)
 {
-    auto node = MycoNet::Inst().GetNode(id);
-    if (node == nullptr) return MN_ERR_NOTFOUND;
+    if (target_node_name == nullptr) return MN_ERR_NULL_POINTER;
+    return MycoNode::PullAnon(net_of(ctx), target_node_name, data_p, size);
+}
+
+
+MN_API int myconet_ctx_pull(myconet_ctx_t *ctx, MycoNet_ID_t id, const char *target_node_name, void *data_p, size_t size)
+{
+    if (target_node_name == nullptr) return MN_ERR_NULL_POINTER;
+    NodeRef node(net_of(ctx), id);
+    if (!node) return MN_ERR_NOTFOUND;
     return node->Pull(target_node_name, data_p, size);
 }
 
+
+MN_API int myconet_ctx_pull_id(myconet_ctx_t *ctx, MycoNet_ID_t id, MycoNet_ID_t target_node_id, void *data_p, size_t size)
+{
+    NodeRef node(net_of(ctx), id);
+    if (!node) return MN_ERR_NOTFOUND;
+    return node->Pull(target_node_id, data_p, size);
+}
+
+
+MN_API int myconet_ctx_pull_next(myconet_ctx_t *ctx, MycoNet_ID_t id, const char *target_node_name, void *data_p, size_t size, uint32_t timeout_ms)
+{
+    if (target_node_name == nullptr) return MN_ERR_NULL_POINTER;
+    NodeRef node(net_of(ctx), id);
+    if (!node) return MN_ERR_NOTFOUND;
+    return node->PullNext(target_node_name, data_p, size, timeout_ms);
+}
+
+
+MN_API int myconet_ctx_pull_next_id(myconet_ctx_t *ctx, MycoNet_ID_t id, MycoNet_ID_t target_node_id, void *data_p, size_t size, uint32_t timeout_ms)
+{
+    NodeRef node(net_of(ctx), id);
+    if (!node) return MN_ERR_NOTFOUND;
+    return node->PullNext(target_node_id, data_p, size, timeout_ms);
+}
+
+
+MN_API int myconet_ctx_notify(myconet_ctx_t *ctx, MycoNet_ID_t id, const char *target_node_name, const void *data_p, size_t size)
+{
+    if (target_node_name == nullptr) return MN_ERR_NULL_POINTER;
+    NodeRef node(net_of(ctx), id);
+    if (!node) return MN_ERR_NOTFOUND;
+    return node->Notify(target_node_name, data_p, size);
+}
+
+
+MN_API int myconet_ctx_notify_id(myconet_ctx_t *ctx, MycoNet_ID_t id, MycoNet_ID_t target_node_id, const void *data_p, size_t size)
+{
+    NodeRef node(net_of(ctx), id);
+    if (!node) return MN_ERR_NOTFOUND;
+    return node->Notify(target_node_id, data_p, size);
+}
+
+
+MN_API int myconet_ctx_request(myconet_ctx_t *ctx, MycoNet_ID_t id, const char *target_node_name, const void *data_p, size_t size,
+                               MycoNet_RespCb_t resp_cb, void *user_data, uint32_t timeout_ms, uint32_t *corr_id)
+{
+    if (target_node_name == nullptr || resp_cb == nullptr) return MN_ERR_NULL_POINTER;
+    NodeRef node(net_of(ctx), id);
+    if (!node) return MN_ERR_NOTFOUND;
+    auto on_resp = [resp_cb, user_data](int status, const void *resp_p, size_t resp_size) {
+        resp_cb(status, resp_p, (uint32_t)resp_size, user_data);
+    };
+    return node->Request(target_node_name, data_p, size, on_resp, timeout_ms, corr_id);
+}
+
+
+MN_API int myconet_ctx_request_wait(myconet_ctx_t *ctx, MycoNet_ID_t id, const char *target_node_name, const void *data_p, size_t size,
+                                    void *resp_p, size_t resp_size, uint32_t timeout_ms)
+{
+    if (target_node_name == nullptr) return MN_ERR_NULL_POINTER;
+    NodeRef node(net_of(ctx), id);
+    if (!node) return MN_ERR_NOTFOUND;
+    return node->Request(target_node_name, data_p, size, resp_p, resp_size, timeout_ms);
+}
+
+
+MN_API int myconet_ctx_reply(myconet_ctx_t *ctx, MycoNet_ID_t id, uint32_t corr_id, const void *data_p, size_t size)
+{
+    NodeRef node(net_of(ctx), id);
+    if (!node) return MN_ERR_NOTFOUND;
+    return node->Reply(corr_id, data_p, size);
+}
+
+
+MN_API int myconet_ctx_expire_requests(myconet_ctx_t *ctx)
+{
+    return net_of(ctx).ExpireRequests();
+}
+
+
+MN_API int myconet_ctx_pub_num(myconet_ctx_t *ctx, MycoNet_ID_t id)
+{
+    NodeRef node(net_of(ctx), id);
+    if (!node) return MN_ERR_NOTFOUND;
+    return node->PubNum();
+}
+
+
+MN_API int myconet_ctx_sub_num(myconet_ctx_t *ctx, MycoNet_ID_t id)
+{
+    NodeRef node(net_of(ctx), id);
+    if (!node) return MN_ERR_NOTFOUND;
+    return node->SubNum();
+}
+
+
+MN_API myconet_node_t *myconet_ctx_node_open(myconet_ctx_t *ctx, MycoNet_ID_t id)
+{
+    auto net = ctx ? ctx->net : MycoNet::GetInst("default");
+    auto node = net->GetNode(id);
+    if (node == nullptr) return nullptr;
+    return new myconet_node{std::move(net), std::move(node)};
+}
+
+
+// ====================================================================
+// default instance
+// ====================================================================
+MN_API int myconet_node_num()
+{
+    return myconet_ctx_node_num(nullptr);
+}
+
+
+MN_API int myconet_create_node(MycoNet_ID_t *id, const char *name, const MycoNet_NodeParam_t *conf)
+{
+    return myconet_ctx_create_node(nullptr, id, name, conf);
+}
+
+
+MN_API int myconet_remove_node_id(MycoNet_ID_t id)
+{
+    return myconet_ctx_remove_node_id(nullptr, id);
+}
+
+
+MN_API int myconet_remove_node_name(const char *name)
+{
+    return myconet_ctx_remove_node_name(nullptr, name);
+}
+
+
+MN_API int myconet_subscribe(MycoNet_ID_t id, const char *target_node_name)
+{
+    return myconet_ctx_subscribe(nullptr, id, target_node_name);
+}
+
+
+MN_API int myconet_unsubscribe(MycoNet_ID_t id, const char *target_node_name)
+{
+    return myconet_ctx_unsubscribe(nullptr, id, target_node_name);
+}
+
+
+MN_API int myconet_unsubscribe_id(MycoNet_ID_t id, MycoNet_ID_t target_node_id)
+{
+    return myconet_ctx_unsubscribe_id(nullptr, id, target_node_id);
+}
+
+
+MN_API int myconet_publish(MycoNet_ID_t id, const void *data_p, size_t size)
+{
+    return myconet_ctx_publish(nullptr, id, data_p, size);
+}
+
+
+MN_API int myconet_pull(MycoNet_ID_t id, const char *target_node_name, void *data_p, size_t size)
+{
+    return myconet_ctx_pull(nullptr, id, target_node_name, data_p, size);
+}
+
 MN_API int myconet_pull_anon(const char *target_node_name, void *data_p, size_t size)
 {
-    return MycoNode::PullAnon(target_node_name, data_p, size);
+    return myconet_ctx_pull_anon(nullptr, target_node_name, data_p, size);
 }
 
 
 MN_API int myconet_pull_id(MycoNet_ID_t id, MycoNet_ID_t target_node_id, void *data_p, size_t size)
 {
-    auto node = MycoNet::Inst().GetNode(id);
-    if (node == nullptr) return MN_ERR_NOTFOUND;
-    return node->Pull(target_node_id, data_p, size);
+    return myconet_ctx_pull_id(nullptr, id, target_node_id, data_p, size);
+}
+
+
+MN_API int myconet_pull_next(MycoNet_ID_t id, const char *target_node_name, void *data_p, size_t size, uint32_t timeout_ms)
+{
+    return myconet_ctx_pull_next(nullptr, id, target_node_name, data_p, size, timeout_ms);
+}
+
+
+MN_API int myconet_pull_next_id(MycoNet_ID_t id, MycoNet_ID_t target_node_id, void *data_p, size_t size, uint32_t timeout_ms)
+{
+    return myconet_ctx_pull_next_id(nullptr, id, target_node_id, data_p, size, timeout_ms);
 }
 
 
 MN_API int myconet_notify(MycoNet_ID_t id, const char *target_node_name, const void *data_p, size_t size)
 {
-    auto node = MycoNet::Inst().GetNode(id);
-    if (node == nullptr) return MN_ERR_NOTFOUND;
-    return node->Notify(target_node_name, data_p, size);
+    return myconet_ctx_notify(nullptr, id, target_node_name, data_p, size);
 }
 
 
 MN_API int myconet_notify_id(MycoNet_ID_t id, MycoNet_ID_t target_node_id, const void *data_p, size_t size)
 {
-    auto node = MycoNet::Inst().GetNode(id);
-    if (node == nullptr) return MN_ERR_NOTFOUND;
-    return node->Notify(target_node_id, data_p, size);
+    return myconet_ctx_notify_id(nullptr, id, target_node_id, data_p, size);
+}
+
+
+MN_API int myconet_request(MycoNet_ID_t id, const char *target_node_name, const void *data_p, size_t size,
+                           MycoNet_RespCb_t resp_cb, void *user_data, uint32_t timeout_ms, uint32_t *corr_id)
+{
+    return myconet_ctx_request(nullptr, id, target_node_name, data_p, size, resp_cb, user_data, timeout_ms, corr_id);
+}
+
+
+MN_API int myconet_request_wait(MycoNet_ID_t id, const char *target_node_name, const void *data_p, size_t size,
+                                void *resp_p, size_t resp_size, uint32_t timeout_ms)
+{
+    return myconet_ctx_request_wait(nullptr, id, target_node_name, data_p, size, resp_p, resp_size, timeout_ms);
+}
+
+
+MN_API int myconet_reply(MycoNet_ID_t id, uint32_t corr_id, const void *data_p, size_t size)
+{
+    return myconet_ctx_reply(nullptr, id, corr_id, data_p, size);
+}
+
+
+MN_API int myconet_expire_requests()
+{
+    return myconet_ctx_expire_requests(nullptr);
 }
 
 
 MN_API int myconet_pub_num(MycoNet_ID_t id)
 {
-    auto node = MycoNet::Inst().GetNode(id);
-    if (node == nullptr) return MN_ERR_NOTFOUND;
-    return node->PubNum();
+    return myconet_ctx_pub_num(nullptr, id);
 }
 
 
 MN_API int myconet_sub_num(MycoNet_ID_t id)
 {
-    auto node = MycoNet::Inst().GetNode(id);
-    if (node == nullptr) return MN_ERR_NOTFOUND;
-    return node->SubNum();
+    return myconet_ctx_sub_num(nullptr, id);
+}
+
+
+// ====================================================================
+// node handles
+// ====================================================================
+MN_API myconet_node_t *myconet_node_open(MycoNet_ID_t id)
+{
+    return myconet_ctx_node_open(nullptr, id);
+}
+
+
+MN_API void myconet_node_close(myconet_node_t *node)
+{
+    delete node;
+}
+
+
+MN_API MycoNet_ID_t myconet_node_id(const myconet_node_t *node)
+{
+    if (node == nullptr) return INVALID_ID;
+    return node->node->MyID();
+}
+
+
+MN_API int myconet_node_publish(myconet_node_t *node, const void *data_p, size_t size)
+{
+    if (node == nullptr) return MN_ERR_NULL_POINTER;
+    MycoNode *self = handle_node(node);
+    if (self == nullptr) return MN_ERR_NOTFOUND;
+    return self->Publish(data_p, size);
+}
+
+
+MN_API int myconet_node_pull(myconet_node_t *node, const char *target_node_name, void *data_p, size_t size)
+{
+    if (node == nullptr || target_node_name == nullptr) return MN_ERR_NULL_POINTER;
+    MycoNode *self = handle_node(node);
+    if (self == nullptr) return MN_ERR_NOTFOUND;
+    return self->Pull(target_node_name, data_p, size);
+}
+
+
+MN_API int myconet_node_pull_id(myconet_node_t *node, MycoNet_ID_t target_node_id, void *data_p, size_t size)
+{
+    if (node == nullptr) return MN_ERR_NULL_POINTER;
+    MycoNode *self = handle_node(node);
+    if (self == nullptr) return MN_ERR_NOTFOUND;
+    return self->Pull(target_node_id, data_p, size);
+}
+
+
+MN_API int myconet_node_notify(myconet_node_t *node, const char *target_node_name, const void *data_p, size_t size)
+{
+    if (node == nullptr || target_node_name == nullptr) return MN_ERR_NULL_POINTER;
+    MycoNode *self = handle_node(node);
+    if (self == nullptr) return MN_ERR_NOTFOUND;
+    return self->Notify(target_node_name, data_p, size);
+}
+
+
+MN_API int myconet_node_notify_id(myconet_node_t *node, MycoNet_ID_t target_node_id, const void *data_p, size_t size)
+{
+    if (node == nullptr) return MN_ERR_NULL_POINTER;
+    MycoNode *self = handle_node(node);
+    if (self == nullptr) return MN_ERR_NOTFOUND;
+    return self->Notify(target_node_id, data_p, size);
 }
 
 }
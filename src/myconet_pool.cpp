@@ -0,0 +1,337 @@
+#include "myconet_pool.hpp"
+#include <map>
+#include <mutex>
+#include <stdlib.h>
+#include <string.h>
+#if defined(__linux__)
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+using namespace MycoNets;
+
+static constexpr size_t POOL_ALIGN = 64;
+static constexpr size_t POOL_MIN_CLASS = 64;
+static constexpr size_t POOL_MAX_CLASS = 1 << 20;
+static constexpr size_t HUGE_PAGE_SIZE = 2 << 20;
+
+// from <numaif.h>, spelled out to avoid a libnuma dependency
+static constexpr int MN_MPOL_PREFERRED = 1;
+static constexpr unsigned MN_MPOL_MF_MOVE = 1 << 1;
+
+static inline size_t round_up(size_t size, size_t align)
+{
+    return (size + align - 1) & ~(align - 1);
+}
+
+// Pools that are still alive, so a thread can hand cached blocks back to the
+// pool it last used without touching a destroyed one. Never freed: instances
+// may be torn down by other static destructors after this TU's.
+static std::mutex live_pools_lock;
+static std::map<uint64_t, MsgPool *> &live_pools = *new std::map<uint64_t, MsgPool *>();
+static std::atomic<uint64_t> next_pool_serial{1};
+
+namespace MycoNets {
+
+    // Per-thread block cache for the pool this thread freed to most recently.
+    struct PoolMagazine {
+        uint64_t serial = 0;
+        uint8_t count[MN_CONFIG_POOL_CLASSES] = {};
+        void *blocks[MN_CONFIG_POOL_CLASSES][MN_CONFIG_POOL_TLS_DEPTH];
+
+        void Flush() {
+            if (serial == 0) return;
+            std::lock_guard<std::mutex> lock(live_pools_lock);
+            auto it = live_pools.find(serial);
+            for (uint8_t cls = 0; cls < MN_CONFIG_POOL_CLASSES; cls++) {
+                // blocks of a dead pool died with its slabs, just forget them
+                if (it != live_pools.end()) {
+                    while (count[cls] > 0) it->second->PushCentral(cls, blocks[cls][--count[cls]]);
+                }
+                count[cls] = 0;
+            }
+            serial = 0;
+        }
+
+        ~PoolMagazine() { Flush(); }
+    };
+
+}
+
+static thread_local PoolMagazine tls_magazine;
+
+MsgPool::MsgPool() :
+    class_num(0),
+    heap_allocs(0),
+    serial(next_pool_serial.fetch_add(1))
+{
+    for (size_t size = POOL_MIN_CLASS; size <= POOL_MAX_CLASS; size <<= 1)
+        AddClass(size);
+
+    std::lock_guard<std::mutex> lock(live_pools_lock);
+    live_pools[serial] = this;
+}
+
+MsgPool::~MsgPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(live_pools_lock);
+        live_pools.erase(serial);
+    }
+    if (tls_magazine.serial == serial) {
+        memset(tls_magazine.count, 0, sizeof(tls_magazine.count));
+        tls_magazine.serial = 0;
+    }
+    for (auto &sc : classes) {
+        for (void *slab : sc.slabs) free(slab);
+    }
+}
+
+int MsgPool::AddClass(size_t block_size)
+{
+    if (block_size == 0) return MN_ERR_INVALID;
+    block_size = round_up(block_size, POOL_ALIGN);
+
+    std::lock_guard<std::mutex> lock(class_lock);
+    uint32_t num = class_num.load(std::memory_order_relaxed);
+    for (uint32_t i = 0; i < num; i++) {
+        if (classes[i].block_size == block_size) return MN_OK;
+    }
+    if (num == classes.size()) return MN_ERR_NOMEM;
+
+    classes[num].block_size = block_size;
+    class_num.store(num + 1, std::memory_order_release);
+    return MN_OK;
+}
+
+int MsgPool::ClassFor(size_t size) const
+{
+    uint32_t num = class_num.load(std::memory_order_acquire);
+    int best = -1;
+    for (uint32_t i = 0; i < num; i++) {
+        size_t block_size = classes[i].block_size;
+        if (block_size >= size && (best < 0 || block_size < classes[best].block_size))
+            best = i;
+    }
+    return best;
+}
+
+int MsgPool::Grow(SizeClass &sc)
+{
+    size_t blocks = MN_CONFIG_POOL_SLAB_SIZE / sc.block_size;
+    if (blocks == 0) blocks = 1;
+
+    uint8_t *slab = static_cast<uint8_t *>(aligned_alloc(POOL_ALIGN, blocks * sc.block_size));
+    if (slab == nullptr) return MN_ERR_NOMEM;
+    heap_allocs.fetch_add(1, std::memory_order_relaxed);
+    sc.slabs.push_back(slab);
+
+    for (size_t i = 0; i < blocks; i++) {
+        void *block = slab + i * sc.block_size;
+        *static_cast<void **>(block) = sc.free_list;
+        sc.free_list = block;
+    }
+    sc.total.fetch_add(blocks, std::memory_order_relaxed);
+    return MN_OK;
+}
+
+void *MsgPool::PopCentral(uint8_t cls)
+{
+    SizeClass &sc = classes[cls];
+    std::lock_guard<std::mutex> lock(sc.lock);
+    if (sc.free_list == nullptr && Grow(sc) != MN_OK) return nullptr;
+    void *block = sc.free_list;
+    sc.free_list = *static_cast<void **>(block);
+    return block;
+}
+
+void MsgPool::PushCentral(uint8_t cls, void *block)
+{
+    SizeClass &sc = classes[cls];
+    std::lock_guard<std::mutex> lock(sc.lock);
+    *static_cast<void **>(block) = sc.free_list;
+    sc.free_list = block;
+}
+
+Buffer MsgPool::Alloc(size_t size)
+{
+    Buffer buf;
+    int cls = ClassFor(size);
+
+    if (cls < 0) {
+        size_t capacity = round_up(size, POOL_ALIGN);
+        buf.data = static_cast<uint8_t *>(aligned_alloc(POOL_ALIGN, capacity));
+        if (buf.data == nullptr) return buf;
+        heap_allocs.fetch_add(1, std::memory_order_relaxed);
+        buf.capacity = capacity;
+        buf.cls = OVERSIZE;
+    } else {
+        void *block = nullptr;
+        PoolMagazine &mag = tls_magazine;
+        if (mag.serial == serial && mag.count[cls] > 0) {
+            block = mag.blocks[cls][--mag.count[cls]];
+        } else {
+            block = PopCentral(cls);
+            if (block == nullptr) return buf;
+        }
+
+        SizeClass &sc = classes[cls];
+        size_t in_use = sc.in_use.fetch_add(1, std::memory_order_relaxed) + 1;
+        size_t high_water = sc.high_water.load(std::memory_order_relaxed);
+        while (in_use > high_water &&
+               !sc.high_water.compare_exchange_weak(high_water, in_use, std::memory_order_relaxed)) {}
+
+        buf.data = static_cast<uint8_t *>(block);
+        buf.capacity = sc.block_size;
+        buf.cls = cls;
+    }
+    buf.size = size;
+    buf.pool = this;
+    return buf;
+}
+
+void MsgPool::FreeStandalone(uint8_t *data, size_t capacity, uint8_t cls)
+{
+#if defined(__linux__)
+    if (cls == MAPPED) {
+        munmap(data, capacity);
+        return;
+    }
+#endif
+    (void)capacity;
+    free(data);
+}
+
+void MsgPool::Free(uint8_t *data, uint8_t cls)
+{
+    classes[cls].in_use.fetch_sub(1, std::memory_order_relaxed);
+
+    PoolMagazine &mag = tls_magazine;
+    if (mag.serial != serial) {
+        mag.Flush();
+        mag.serial = serial;
+    }
+    if (mag.count[cls] < MN_CONFIG_POOL_TLS_DEPTH) {
+        mag.blocks[cls][mag.count[cls]++] = data;
+        return;
+    }
+    PushCentral(cls, data);
+}
+
+int MsgPool::Reserve(size_t size, size_t count)
+{
+    int cls = ClassFor(size);
+    if (cls < 0) return MN_ERR_NOSUPPORT;
+
+    SizeClass &sc = classes[cls];
+    std::lock_guard<std::mutex> lock(sc.lock);
+    size_t free_num = 0;
+    for (void *block = sc.free_list; block && free_num < count; block = *static_cast<void **>(block))
+        free_num++;
+    while (free_num < count) {
+        size_t before = sc.total.load(std::memory_order_relaxed);
+        if (Grow(sc) != MN_OK) return MN_ERR_NOMEM;
+        free_num += sc.total.load(std::memory_order_relaxed) - before;
+    }
+    return MN_OK;
+}
+
+void MsgPool::Stats(std::vector<PoolStats> &out) const
+{
+    out.clear();
+    uint32_t num = class_num.load(std::memory_order_acquire);
+    for (uint32_t i = 0; i < num; i++) {
+        const SizeClass &sc = classes[i];
+        PoolStats stats = {};
+        stats.block_size = sc.block_size;
+        stats.total = sc.total.load(std::memory_order_relaxed);
+        stats.in_use = sc.in_use.load(std::memory_order_relaxed);
+        stats.high_water = sc.high_water.load(std::memory_order_relaxed);
+        out.push_back(stats);
+    }
+}
+
+Buffer MsgPool::AllocHeap(size_t size)
+{
+    Buffer buf;
+    size_t capacity = round_up(size ? size : 1, POOL_ALIGN);
+    buf.data = static_cast<uint8_t *>(aligned_alloc(POOL_ALIGN, capacity));
+    if (buf.data == nullptr) return buf;
+    memset(buf.data, 0, capacity);
+    buf.size = size;
+    buf.capacity = capacity;
+    buf.cls = OVERSIZE;
+    return buf;
+}
+
+Buffer MsgPool::AllocPlaced(size_t size, int numa_node, bool huge_pages)
+{
+#if defined(__linux__)
+    if (numa_node == NUMA_ANY && !huge_pages) return AllocHeap(size);
+
+    Buffer buf;
+    const size_t page_size = (size_t)sysconf(_SC_PAGESIZE);
+    size_t length = round_up(size ? size : 1, huge_pages ? HUGE_PAGE_SIZE : page_size);
+    void *addr = MAP_FAILED;
+
+    if (huge_pages) {
+        addr = mmap(nullptr, length, PROT_READ | PROT_WRITE,
+                    MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB | (21 << MAP_HUGE_SHIFT), -1, 0);
+        if (addr == MAP_FAILED) {
+            // no reserved hugetlbfs pages: over-map, trim to a 2 MB boundary, ask for THP
+            size_t span = length + HUGE_PAGE_SIZE;
+            uint8_t *raw = static_cast<uint8_t *>(mmap(nullptr, span, PROT_READ | PROT_WRITE,
+                                                       MAP_PRIVATE | MAP_ANONYMOUS, -1, 0));
+            if (raw != MAP_FAILED) {
+                uint8_t *aligned = reinterpret_cast<uint8_t *>(round_up(reinterpret_cast<uintptr_t>(raw), HUGE_PAGE_SIZE));
+                if (aligned > raw) munmap(raw, aligned - raw);
+                if (raw + span > aligned + length) munmap(aligned + length, raw + span - (aligned + length));
+                addr = aligned;
+                madvise(addr, length, MADV_HUGEPAGE);
+            }
+        }
+    } else {
+        addr = mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    }
+    if (addr == MAP_FAILED) return AllocHeap(size);
+
+    buf.data = static_cast<uint8_t *>(addr);
+    buf.size = size;
+    buf.capacity = length;
+    buf.cls = MAPPED;
+    // bind before the first touch so pages fault in on the right node
+    if (numa_node >= 0) BindNode(buf, numa_node);
+    return buf;
+#else
+    (void)numa_node;
+    (void)huge_pages;
+    return AllocHeap(size);
+#endif
+}
+
+int MsgPool::BindNode(Buffer &buf, int numa_node)
+{
+#if defined(__linux__)
+    if (!buf || buf.cls != MAPPED) return MN_ERR_NOSUPPORT;
+    if (numa_node < 0 || numa_node >= 64) return MN_ERR_INVALID;
+
+    unsigned long nodemask = 1UL << numa_node;
+    long ret = syscall(SYS_mbind, buf.data, buf.capacity, MN_MPOL_PREFERRED,
+                       &nodemask, sizeof(nodemask) * 8, MN_MPOL_MF_MOVE);
+    return ret == 0 ? MN_OK : MN_ERR_FAIL;
+#else
+    (void)buf;
+    (void)numa_node;
+    return MN_ERR_NOSUPPORT;
+#endif
+}
+
+int MsgPool::CurrentNumaNode()
+{
+#if defined(__linux__)
+    unsigned cpu = 0, node = 0;
+    if (syscall(SYS_getcpu, &cpu, &node, nullptr) == 0) return (int)node;
+#endif
+    return 0;
+}
@@ -0,0 +1,199 @@
+/**
+ * Throughput benchmarks for the hot paths.
+ *
+ *   make bench && ./bin/bench-myconet [readers] [seconds]
+ *
+ * Run under `perf stat -e cache-misses,LLC-load-misses` to see the
+ * coherence traffic between pulling and publishing cores.
+ */
+#include "myconet.hpp"
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace MycoNets;
+using Clock = std::chrono::steady_clock;
+
+struct Sample {
+    uint64_t stamp;
+    uint8_t payload[56];
+};
+
+// readers Pull one cached node while a single thread keeps publishing to it
+static void bench_pull_publish(int readers, double seconds)
+{
+    auto net = MycoNet::GetInst("bench");
+
+    NodeParam param = {};
+    param.size = sizeof(Sample);
+    param.conflags = CONF_CACHED;
+    auto sensor = net->NewNode("sensor", param);
+
+    std::atomic<bool> running{true};
+    std::atomic<uint64_t> pulls{0};
+    std::atomic<uint64_t> publishes{0};
+    std::vector<std::thread> threads;
+
+    for (int i = 0; i < readers; i++) {
+        threads.emplace_back([&, i]() {
+            auto reader = net->NewNode("reader" + std::to_string(i), NodeParam{});
+            const NodeID target = sensor->MyID();
+            Sample sample;
+            uint64_t count = 0;
+            while (running.load(std::memory_order_relaxed)) {
+                reader->Pull(target, &sample, sizeof(sample));
+                count++;
+            }
+            pulls += count;
+        });
+    }
+    threads.emplace_back([&]() {
+        Sample sample = {};
+        uint64_t count = 0;
+        while (running.load(std::memory_order_relaxed)) {
+            sample.stamp = count;
+            sensor->Publish(&sample, sizeof(sample));
+            count++;
+        }
+        publishes += count;
+    });
+
+    auto start = Clock::now();
+    std::this_thread::sleep_for(std::chrono::duration<double>(seconds));
+    running = false;
+    for (auto &t : threads) t.join();
+    double elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+
+    printf("pull+publish  readers=%-3d pulls/s=%-12.0f publishes/s=%.0f\n",
+           readers, pulls / elapsed, publishes / elapsed);
+    MycoNet::DelInst("bench");
+}
+
+// one thread driving an instance, with and without Threading::SINGLE
+static void bench_threading(double seconds)
+{
+    for (Threading mode : {Threading::SHARED, Threading::SINGLE}) {
+        auto net = MycoNet::GetInst("bench_threading", mode);
+        NodeParam param = {};
+        param.size = sizeof(Sample);
+        param.conflags = CONF_CACHED;
+        auto sensor = net->NewNode("sensor", param);
+        NodeParam sub_param = {};
+        sub_param.event_msk = EVENT_PUBLISH;
+        sub_param.event_cb = [](const EventParam *) {};
+        auto reader = net->NewNode("reader", sub_param);
+        reader->Subscribe("sensor");
+        const NodeID target = sensor->MyID();
+
+        Sample sample = {};
+        uint64_t count = 0;
+        auto start = Clock::now();
+        auto until = start + std::chrono::duration<double>(seconds);
+        while (Clock::now() < until) {
+            for (int i = 0; i < 1000; i++) {
+                sensor->Publish(&sample, sizeof(sample));
+                reader->Pull(target, &sample, sizeof(sample));
+            }
+            count += 1000;
+        }
+        double elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+        printf("%-22s ns/(publish+pull)=%.1f\n", mode == Threading::SINGLE ? "threading SINGLE" : "threading SHARED",
+               elapsed * 1e9 / count);
+        MycoNet::DelInst("bench_threading");
+    }
+}
+
+// one publisher with many subscribers, fan-out spread over 1..max_cores cores
+static void bench_fanout(int max_cores, double seconds)
+{
+    const int subscribers = 2000;
+    for (int cores = 1; cores <= max_cores; cores *= 2) {
+        auto net = MycoNet::GetInst("bench_fanout");
+        if (cores > 1) net->StartFanout(cores - 1);
+        NodeParam param = {};
+        param.size = sizeof(Sample);
+        param.fanout_threshold = cores > 1 ? 64 : 0;
+        auto sensor = net->NewNode("sensor", param);
+
+        // one cache line per subscriber, so the callbacks share nothing
+        std::vector<uint64_t> sinks(subscribers * 8);
+        NodeParam sub_param = {};
+        sub_param.event_msk = EVENT_PUBLISH;
+        std::vector<std::shared_ptr<MycoNode>> subs;
+        for (int i = 0; i < subscribers; i++) {
+            uint64_t *sink = &sinks[i * 8];
+            sub_param.event_cb = [sink](const EventParam *p) {
+                // a little per-subscriber work, about a cache line of reads
+                const uint8_t *bytes = static_cast<const uint8_t *>(p->data_p);
+                for (uint32_t i = 0; i < p->size; i++) *sink += bytes[i];
+            };
+            subs.push_back(net->NewNode("sub" + std::to_string(i), sub_param));
+            subs.back()->Subscribe("sensor");
+        }
+
+        Sample sample = {};
+        uint64_t count = 0;
+        auto start = Clock::now();
+        auto until = start + std::chrono::duration<double>(seconds);
+        while (Clock::now() < until) {
+            sensor->Publish(&sample, sizeof(sample));
+            count++;
+        }
+        double elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+        printf("fanout subs=%-5d cores=%-3d us/publish=%.1f\n", subscribers, cores, elapsed * 1e6 / count);
+        MycoNet::DelInst("bench_fanout");
+    }
+}
+
+// per-call overhead of the C wrappers against calling the node directly
+static void bench_c_api(double seconds)
+{
+    myconet_init();
+    MycoNet_NodeParam_t conf = {};
+    conf.size = sizeof(Sample);
+    conf.conflags = CONF_CACHED;
+    MycoNet_ID_t id = INVALID_ID;
+    myconet_create_node(&id, "c_sensor", &conf);
+    auto node = MycoNet::Inst().GetNode(id);
+    myconet_node_t *handle = myconet_node_open(id);
+
+    Sample sample = {};
+    auto run = [&](const char *name, const std::function<void()> &op) {
+        uint64_t count = 0;
+        auto start = Clock::now();
+        auto until = start + std::chrono::duration<double>(seconds);
+        while (Clock::now() < until) {
+            for (int i = 0; i < 1000; i++) op();
+            count += 1000;
+        }
+        double elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+        printf("%-22s ns/op=%.1f\n", name, elapsed * 1e9 / count);
+    };
+    run("c++ Publish", [&]() { node->Publish(&sample, sizeof(sample)); });
+    run("myconet_publish", [&]() { myconet_publish(id, &sample, sizeof(sample)); });
+    run("myconet_node_publish", [&]() { myconet_node_publish(handle, &sample, sizeof(sample)); });
+
+    myconet_node_close(handle);
+    node.reset();
+    myconet_deinit();
+}
+
+int main(int argc, char **argv)
+{
+    int readers = argc > 1 ? atoi(argv[1]) : (int)std::thread::hardware_concurrency() - 1;
+    double seconds = argc > 2 ? atof(argv[2]) : 1.0;
+    if (readers < 1) readers = 1;
+
+    printf("sizeof(MycoNode)=%zu alignof(MycoNode)=%zu\n", sizeof(MycoNode), alignof(MycoNode));
+    for (int n = 1; n <= readers; n *= 2)
+        bench_pull_publish(n, seconds);
+    bench_threading(seconds);
+    bench_fanout(readers + 1, seconds);
+    bench_c_api(seconds);
+    return 0;
+}
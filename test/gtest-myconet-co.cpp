@@ -0,0 +1,226 @@
+#include "myconet_co.hpp"
+#include <gtest/gtest.h>
+#include <deque>
+#include <thread>
+
+using namespace MycoNets;
+using namespace MycoNets::co;
+
+// ====================================================================
+// 测试固件类
+// ====================================================================
+class MycoNetCoTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        MycoNet::DelInst("co_test");
+        net = MycoNet::GetInst("co_test");
+    }
+
+    void TearDown() override {
+        MycoNet::DelInst("co_test");
+    }
+
+    std::shared_ptr<MycoNet> net;
+};
+
+static NodeParam cached_int_param()
+{
+    NodeParam param = {};
+    param.size = sizeof(int);
+    param.conflags = CONF_CACHED;
+    return param;
+}
+
+// ====================================================================
+// 协程接口测试
+// ====================================================================
+TEST_F(MycoNetCoTest, NextPublishResumesInline) {
+    auto publisher = net->NewNode("publisher", cached_int_param());
+    auto co_node = CoNode::Create(*net, "co_node", NodeParam{});
+    ASSERT_NE(co_node, nullptr);
+
+    int received = 0;
+    int status = MN_ERR_FAIL;
+    bool finished = false;
+    auto consumer = [&]() -> Task<void> {
+        status = co_await co_node->NextPublish("publisher", &received, sizeof(received));
+        finished = true;
+    };
+    Spawn(consumer());
+    EXPECT_FALSE(finished);
+
+    int data = 7;
+    publisher->Publish(&data, sizeof(data));
+    EXPECT_TRUE(finished);
+    EXPECT_EQ(status, MN_OK);
+    EXPECT_EQ(received, 7);
+
+    // 不存在的主题立即返回
+    auto missing = [&]() -> Task<int> {
+        co_return co_await co_node->NextPublish("nonexistent", &received, sizeof(received));
+    };
+    auto wrapper = [&]() -> Task<void> { status = co_await missing(); };
+    Spawn(wrapper());
+    EXPECT_EQ(status, MN_ERR_NOTFOUND);
+}
+
+TEST_F(MycoNetCoTest, ExecutorControlsResumption) {
+    std::deque<std::coroutine_handle<>> queue;
+    auto co_node = CoNode::Create(*net, "co_node", NodeParam{},
+        [&](std::coroutine_handle<> h) { queue.push_back(h); });
+    auto publisher = net->NewNode("publisher", cached_int_param());
+
+    int received = 0;
+    bool finished = false;
+    auto consumer = [&]() -> Task<void> {
+        co_await co_node->NextPublish("publisher", &received, sizeof(received));
+        finished = true;
+    };
+    Spawn(consumer());
+
+    int data = 11;
+    publisher->Publish(&data, sizeof(data));
+    EXPECT_FALSE(finished); // 只是被投递到执行器
+    ASSERT_EQ(queue.size(), 1u);
+    queue.front().resume();
+    queue.pop_front();
+    EXPECT_TRUE(finished);
+    EXPECT_EQ(received, 11);
+}
+
+TEST_F(MycoNetCoTest, RequestAwaitsDeferredReply) {
+    uint32_t pending_corr_id = 0;
+    NodeParam server_param = {};
+    server_param.event_msk = EVENT_REQUEST;
+    server_param.event_cb = [&](const EventParam *param) { pending_corr_id = param->corr_id; };
+    auto server = net->NewNode("server", server_param);
+    auto co_node = CoNode::Create(*net, "co_node", NodeParam{});
+
+    int req = 5, resp = 0, status = MN_ERR_FAIL;
+    bool finished = false;
+    auto client = [&]() -> Task<void> {
+        status = co_await co_node->Request("server", &req, sizeof(req), &resp, sizeof(resp), 1000);
+        finished = true;
+    };
+    Spawn(client());
+    EXPECT_FALSE(finished);
+
+    std::thread replier([&]() {
+        int answer = 50;
+        server->Reply(pending_corr_id, &answer, sizeof(answer));
+    });
+    replier.join();
+    EXPECT_TRUE(finished);
+    EXPECT_EQ(status, MN_OK);
+    EXPECT_EQ(resp, 50);
+}
+
+TEST_F(MycoNetCoTest, StreamBuffersSamples) {
+    auto publisher = net->NewNode("publisher", cached_int_param());
+    auto co_node = CoNode::Create(*net, "co_node", NodeParam{});
+    auto stream = co_node->Subscribe("publisher", 4, sizeof(int));
+    ASSERT_NE(stream, nullptr);
+
+    // 读者未就绪时先缓存，溢出时丢弃最旧的
+    for (int i = 1; i <= 6; ++i) publisher->Publish(&i, sizeof(i));
+    EXPECT_EQ(stream->Dropped(), 2u);
+
+    std::vector<int> got;
+    auto reader = [&]() -> Task<void> {
+        for (int i = 0; i < 5; ++i) {
+            int value = 0;
+            if (co_await stream->Next(&value, sizeof(value)) == MN_OK) got.push_back(value);
+        }
+    };
+    Spawn(reader());
+    EXPECT_EQ(got, (std::vector<int>{3, 4, 5, 6}));
+
+    int last = 42;
+    publisher->Publish(&last, sizeof(last));
+    EXPECT_EQ(got, (std::vector<int>{3, 4, 5, 6, 42}));
+}
+
+TEST_F(MycoNetCoTest, FramesAreReused) {
+    auto publisher = net->NewNode("publisher", cached_int_param());
+    auto co_node = CoNode::Create(*net, "co_node", NodeParam{});
+
+    int received = 0;
+    auto consumer = [&]() -> Task<void> {
+        co_await co_node->NextPublish("publisher", &received, sizeof(received));
+    };
+
+    // 预热后，后续消息不再分配协程帧
+    Spawn(consumer());
+    publisher->Publish(&received, sizeof(received));
+    size_t allocs = frame_pool.HeapAllocs();
+    for (int i = 0; i < 100; ++i) {
+        Spawn(consumer());
+        publisher->Publish(&i, sizeof(i));
+        EXPECT_EQ(received, i);
+    }
+    EXPECT_EQ(frame_pool.HeapAllocs(), allocs);
+}
+
+TEST_F(MycoNetCoTest, DestroyedWaiterIsRemoved) {
+    auto publisher = net->NewNode("publisher", cached_int_param());
+    auto co_node = CoNode::Create(*net, "co_node", NodeParam{});
+    auto stream = co_node->Subscribe("publisher", 2, sizeof(int));
+    ASSERT_NE(stream, nullptr);
+
+    // 协程挂起时被销毁，等待者要从节点和流上摘除
+    int received = 0, next = 0;
+    bool resumed = false;
+    {
+        auto consumer = [&]() -> Task<void> {
+            co_await co_node->NextPublish("publisher", &received, sizeof(received));
+            resumed = true;
+        };
+        auto reader = [&]() -> Task<void> {
+            co_await stream->Next(&next, sizeof(next));
+            resumed = true;
+        };
+        Task<void> waiting = consumer();
+        Task<void> reading = reader();
+        waiting.await_suspend(std::noop_coroutine()).resume();
+        reading.await_suspend(std::noop_coroutine()).resume();
+    }
+    int value = 5;
+    EXPECT_EQ(publisher->Publish(&value, sizeof(value)), MN_OK);
+    EXPECT_FALSE(resumed);
+    EXPECT_EQ(received, 0);
+
+    // 流上的样本留给下一个读者
+    auto reader = [&]() -> Task<void> {
+        co_await stream->Next(&next, sizeof(next));
+        resumed = true;
+    };
+    Spawn(reader());
+    EXPECT_TRUE(resumed);
+    EXPECT_EQ(next, 5);
+}
+
+TEST_F(MycoNetCoTest, DestroyedRequestIsCancelled) {
+    uint32_t pending_corr_id = 0;
+    NodeParam server_param = {};
+    server_param.event_msk = EVENT_REQUEST;
+    server_param.event_cb = [&](const EventParam *param) { pending_corr_id = param->corr_id; };
+    auto server = net->NewNode("server", server_param);
+    auto co_node = CoNode::Create(*net, "co_node", NodeParam{});
+
+    // 等待回复的协程被销毁后请求随之取消，迟到的回复不再写入已释放的帧
+    int req = 5, resp = 0;
+    bool finished = false;
+    {
+        auto client = [&]() -> Task<void> {
+            co_await co_node->Request("server", &req, sizeof(req), &resp, sizeof(resp));
+            finished = true;
+        };
+        Task<void> waiting = client();
+        waiting.await_suspend(std::noop_coroutine()).resume();
+        EXPECT_NE(pending_corr_id, 0u);
+    }
+    int answer = 50;
+    EXPECT_EQ(server->Reply(pending_corr_id, &answer, sizeof(answer)), MN_ERR_NOTFOUND);
+    EXPECT_FALSE(finished);
+    EXPECT_EQ(resp, 0);
+}
@@ -5,6 +5,8 @@
 #include <vector>
 #include <string>
 #include <functional>
+#include <algorithm>
+#include <string.h>
 
 using namespace MycoNets;
 
@@ -116,6 +118,16 @@ TEST_F(MycoNetTest, NodeBasicProperties) {
     EXPECT_EQ(node->PubNum(), 0);
 }
 
+TEST_F(MycoNetTest, NodeCacheLineAligned) {
+    // 节点按缓存行对齐分配，可变状态不与描述符共享缓存行
+    NodeParam param = {};
+    std::vector<std::shared_ptr<MycoNode>> nodes;
+    for (int i = 0; i < 8; ++i) {
+        nodes.push_back(net->NewNode("node" + std::to_string(i), param));
+        EXPECT_EQ(reinterpret_cast<uintptr_t>(nodes.back().get()) % MN_CONFIG_CACHE_LINE, 0u);
+    }
+}
+
 TEST_F(MycoNetTest, NodeSubscribeUnsubscribe) {
     // 创建有事件回调的节点才能订阅
     NodeParam param1 = {};
@@ -215,6 +227,115 @@ TEST_F(MycoNetTest, EventCallbackNotify) {
     EXPECT_EQ(received_sender, notifier->MyID());
 }
 
+// ====================================================================
+// 请求/应答测试
+// ====================================================================
+TEST_F(MycoNetTest, RequestReplyDeferred) {
+    std::mutex pending_mutex;
+    std::vector<std::pair<uint32_t, int>> pending; // corr_id, request value
+
+    // 服务端先记录请求，稍后在其他线程中批量应答
+    NodeParam server_param = {};
+    server_param.event_msk = EVENT_REQUEST;
+    server_param.event_cb = [&](const EventParam* param) {
+        std::lock_guard<std::mutex> lock(pending_mutex);
+        pending.emplace_back(param->corr_id, *static_cast<int*>(param->data_p));
+    };
+    auto server = net->NewNode("server", server_param);
+    auto client = net->NewNode("client", NodeParam{});
+
+    std::atomic<int> resp_count{0};
+    std::atomic<int> resp_sum{0};
+    const int NUM_REQUESTS = 16;
+    for (int i = 0; i < NUM_REQUESTS; ++i) {
+        uint32_t corr_id = 0;
+        EXPECT_EQ(client->Request("server", &i, sizeof(i), [&](int status, const void* data_p, size_t size) {
+            EXPECT_EQ(status, MN_OK);
+            EXPECT_EQ(size, sizeof(int));
+            resp_sum += *static_cast<const int*>(data_p);
+            resp_count++;
+        }, 1000, &corr_id), MN_OK);
+        EXPECT_NE(corr_id, 0u);
+    }
+    EXPECT_EQ(resp_count, 0);
+
+    std::thread replier([&]() {
+        std::lock_guard<std::mutex> lock(pending_mutex);
+        for (auto& [corr_id, value] : pending) {
+            int answer = value * 2;
+            EXPECT_EQ(server->Reply(corr_id, &answer, sizeof(answer)), MN_OK);
+        }
+    });
+    replier.join();
+
+    EXPECT_EQ(resp_count, NUM_REQUESTS);
+    EXPECT_EQ(resp_sum, NUM_REQUESTS * (NUM_REQUESTS - 1));
+
+    // 重复应答同一个请求
+    EXPECT_EQ(server->Reply(pending.front().first, &resp_sum, sizeof(int)), MN_ERR_NOTFOUND);
+}
+
+TEST_F(MycoNetTest, RequestBlockingAndTimeout) {
+    uint32_t last_corr_id = 0;
+    NodeParam server_param = {};
+    server_param.event_msk = EVENT_REQUEST;
+    server_param.event_cb = [&](const EventParam* param) {
+        last_corr_id = param->corr_id;
+        int value = *static_cast<int*>(param->data_p);
+        if (value >= 0) { // 负数请求不立即应答
+            int answer = value + 1;
+            net->GetNode(param->recver)->Reply(param->corr_id, &answer, sizeof(answer));
+        }
+    };
+    auto server = net->NewNode("server", server_param);
+    auto client = net->NewNode("client", NodeParam{});
+    auto intruder = net->NewNode("intruder", NodeParam{});
+
+    // 回调内同步应答
+    int req = 41, resp = 0;
+    EXPECT_EQ(client->Request("server", &req, sizeof(req), &resp, sizeof(resp), 1000), MN_OK);
+    EXPECT_EQ(resp, 42);
+
+    // 超时后的迟到应答
+    req = -1;
+    EXPECT_EQ(client->Request("server", &req, sizeof(req), &resp, sizeof(resp), 10), MN_ERR_TIMEOUT);
+    EXPECT_EQ(server->Reply(last_corr_id, &req, sizeof(req)), MN_ERR_NOTFOUND);
+
+    // 过期清理会以超时状态回调
+    std::atomic<int> timeout_count{0};
+    EXPECT_EQ(client->Request("server", &req, sizeof(req), [&](int status, const void*, size_t) {
+        if (status == MN_ERR_TIMEOUT) timeout_count++;
+    }, 1), MN_OK);
+    // 只有服务端可以应答
+    EXPECT_EQ(intruder->Reply(last_corr_id, &req, sizeof(req)), MN_ERR_ACCESS);
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    EXPECT_EQ(net->ExpireRequests(), 1);
+    EXPECT_EQ(timeout_count, 1);
+
+    // 不调用 ExpireRequests 时，下一次请求或应答会顺带清理过期请求
+    auto count_timeout = [&](int status, const void*, size_t) {
+        if (status == MN_ERR_TIMEOUT) timeout_count++;
+    };
+    EXPECT_EQ(client->Request("server", &req, sizeof(req), count_timeout, 1), MN_OK);
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    req = 1;
+    EXPECT_EQ(client->Request("server", &req, sizeof(req), &resp, sizeof(resp), 1000), MN_OK);
+    EXPECT_EQ(timeout_count, 2);
+
+    req = -1;
+    EXPECT_EQ(client->Request("server", &req, sizeof(req), count_timeout, 1), MN_OK);
+    const uint32_t overdue_corr_id = last_corr_id;
+    EXPECT_EQ(client->Request("server", &req, sizeof(req), count_timeout), MN_OK);
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    EXPECT_EQ(server->Reply(last_corr_id, &req, sizeof(req)), MN_OK);
+    EXPECT_EQ(timeout_count, 3);
+    EXPECT_EQ(server->Reply(overdue_corr_id, &req, sizeof(req)), MN_ERR_NOTFOUND);
+    EXPECT_EQ(net->ExpireRequests(), 0);
+
+    // 目标不支持请求
+    EXPECT_EQ(client->Request("intruder", &req, sizeof(req), &resp, sizeof(resp), 10), MN_ERR_NOSUPPORT);
+}
+
 // ====================================================================
 // 缓存功能测试
 // ====================================================================
@@ -297,6 +418,944 @@ TEST_F(MycoNetTest, PullFromCache) {
     EXPECT_EQ(puller->Pull("nonexistent", &result, sizeof(result)), MN_ERR_NOTFOUND);
 }
 
+TEST_F(MycoNetTest, HistoryRing) {
+    NodeParam param = {};
+    param.size = sizeof(int);
+    param.conflags = (NodeFlag)(CONF_CACHED | CONF_LATCHED);
+    param.history = 4;
+    auto sensor = net->NewNode("sensor", param);
+    auto fusion = net->NewNode("fusion", NodeParam{});
+
+    for (int i = 1; i <= 6; ++i) sensor->Publish(&i, sizeof(i));
+
+    // 单样本读取仍返回最新值
+    int value = 0;
+    EXPECT_EQ(fusion->Pull("sensor", &value, sizeof(value)), MN_INFO_CACHE_PULLED);
+    EXPECT_EQ(value, 6);
+
+    // 按序号读取，已被覆盖或尚未发布的返回 NODATA
+    EXPECT_EQ(fusion->PullAt("sensor", 3, &value, sizeof(value)), MN_INFO_CACHE_PULLED);
+    EXPECT_EQ(value, 3);
+    EXPECT_EQ(fusion->PullAt("sensor", 2, &value, sizeof(value)), MN_ERR_NODATA);
+    EXPECT_EQ(fusion->PullAt("sensor", 7, &value, sizeof(value)), MN_ERR_NODATA);
+
+    // 最新 n 个，以及从某序号开始的区间（自动截到最旧保留样本）
+    int range[8] = {};
+    uint64_t first_seq = 0;
+    uint32_t pulled = 0;
+    EXPECT_EQ(fusion->PullRange(sensor->MyID(), 0, 3, range, sizeof(int), &first_seq, &pulled), MN_INFO_CACHE_PULLED);
+    EXPECT_EQ(first_seq, 4u);
+    EXPECT_EQ(pulled, 3u);
+    EXPECT_EQ(range[0], 4);
+    EXPECT_EQ(range[2], 6);
+    EXPECT_EQ(fusion->PullRange("sensor", 1, 8, range, sizeof(int), &first_seq, &pulled), MN_INFO_CACHE_PULLED);
+    EXPECT_EQ(first_seq, 3u);
+    EXPECT_EQ(pulled, 4u);
+    EXPECT_EQ(range[3], 6);
+
+    // 订阅时按从旧到新重放整个环
+    std::vector<int> latched;
+    NodeParam sub_param = {};
+    sub_param.event_msk = EVENT_LATCHED;
+    sub_param.event_cb = [&](const EventParam* p) { latched.push_back(*static_cast<int*>(p->data_p)); };
+    auto late = net->NewNode("late", sub_param);
+    EXPECT_EQ(late->Subscribe("sensor"), MN_OK);
+    EXPECT_EQ(latched, (std::vector<int>{3, 4, 5, 6}));
+}
+
+TEST_F(MycoNetTest, PublishMoveBuffer) {
+    NodeParam param = {};
+    param.size = sizeof(int);
+    param.conflags = CONF_CACHED;
+    auto producer = net->NewNode("producer", param);
+
+    const void *seen = nullptr;
+    int seen_value = 0;
+    bool write_back = false;
+    int write_ret = MN_OK;
+    NodeParam sub_param = {};
+    sub_param.event_msk = EVENT_PUBLISH;
+    sub_param.event_cb = [&](const EventParam *p) {
+        seen = p->data_p;
+        seen_value = *static_cast<int *>(p->data_p);
+        if (write_back) {
+            write_back = false;
+            int v = -1;
+            write_ret = producer->Publish(&v, sizeof(v));
+        }
+    };
+    auto consumer = net->NewNode("consumer", sub_param);
+    EXPECT_EQ(consumer->Subscribe("producer"), MN_OK);
+
+    // 双缓冲：发布后拿回旧缓存继续写，两块内存轮流使用
+    Buffer front = producer->Loan();
+    ASSERT_TRUE(front);
+    const uint8_t *first = front.Data();
+    *reinterpret_cast<int *>(front.Data()) = 1;
+    EXPECT_EQ(producer->Publish(std::move(front), &front), MN_OK);
+    EXPECT_EQ(seen, first);
+    EXPECT_EQ(seen_value, 1);
+    ASSERT_TRUE(front);
+    const uint8_t *second = front.Data();
+    EXPECT_NE(second, first);
+
+    *reinterpret_cast<int *>(front.Data()) = 2;
+    EXPECT_EQ(producer->Publish(std::move(front), &front), MN_OK);
+    EXPECT_EQ(seen, second);
+    EXPECT_EQ(front.Data(), first);
+    int value = 0;
+    EXPECT_EQ(consumer->Pull("producer", &value, sizeof(value)), MN_INFO_CACHE_PULLED);
+    EXPECT_EQ(value, 2);
+
+    // 订阅者仍在读取被接管的缓存块时，其它写入返回 MN_ERR_BUSY，样本不被撕裂
+    write_back = true;
+    *reinterpret_cast<int *>(front.Data()) = 3;
+    EXPECT_EQ(producer->Publish(std::move(front), &front), MN_OK);
+    EXPECT_EQ(write_ret, MN_ERR_BUSY);
+    EXPECT_EQ(consumer->Pull("producer", &value, sizeof(value)), MN_INFO_CACHE_PULLED);
+    EXPECT_EQ(value, 3);
+    // 普通发布不占用缓存块，回调中的写入照常进行
+    write_back = true;
+    value = 4;
+    EXPECT_EQ(producer->Publish(&value, sizeof(value)), MN_OK);
+    EXPECT_EQ(write_ret, MN_OK);
+    EXPECT_EQ(consumer->Pull("producer", &value, sizeof(value)), MN_INFO_CACHE_PULLED);
+    EXPECT_EQ(value, -1);
+
+    // 尺寸不符时不接管缓冲区
+    Buffer wrong = net->Pool().Alloc(sizeof(int) * 2);
+    EXPECT_EQ(producer->Publish(std::move(wrong), nullptr), MN_ERR_SIZE_MISMATCH);
+    EXPECT_TRUE(wrong);
+
+    // 实例先于节点销毁时，池中的缓存块已被替换为独立内存，节点析构不再访问池
+    front.Reset();
+    wrong.Reset();
+    MycoNet::DelInst("test");
+    net.reset();
+    producer.reset();
+}
+
+TEST_F(MycoNetTest, PublishRegion) {
+    struct World {
+        uint8_t bytes[MN_CONFIG_REGION_CHUNK * 4];
+    };
+    NodeParam param = {};
+    param.size = sizeof(World);
+    param.conflags = CONF_CACHED;
+    auto world = net->NewNode("world", param);
+
+    uint32_t seen_offset = 0, seen_size = 0;
+    int full_events = 0;
+    NodeParam sub_param = {};
+    sub_param.event_msk = EVENT_PUBLISH | EVENT_PUBLISH_REGION;
+    sub_param.event_cb = [&](const EventParam *p) {
+        if (p->event == EVENT_PUBLISH) {
+            full_events++;
+            return;
+        }
+        seen_offset = p->offset;
+        seen_size = p->size;
+    };
+    auto consumer = net->NewNode("consumer", sub_param);
+    EXPECT_EQ(consumer->Subscribe("world"), MN_OK);
+
+    World w = {};
+    memset(w.bytes, 1, sizeof(w.bytes));
+    EXPECT_EQ(world->Publish(&w, sizeof(w)), MN_OK);
+    EXPECT_EQ(full_events, 1);
+
+    // 初次同步拿到整块
+    World mirror = {};
+    uint64_t since = 0;
+    EXPECT_EQ(consumer->PullDirty("world", &since, &mirror, sizeof(mirror)), MN_INFO_CACHE_PULLED);
+    EXPECT_EQ(since, 1u);
+    EXPECT_EQ(memcmp(&mirror, &w, sizeof(w)), 0);
+    EXPECT_EQ(consumer->PullDirty("world", &since, &mirror, sizeof(mirror)), MN_ERR_NODATA);
+
+    // 只改第三个块中的几个字节
+    const uint8_t patch[4] = {9, 9, 9, 9};
+    const size_t offset = MN_CONFIG_REGION_CHUNK * 2 + 10;
+    EXPECT_EQ(world->PublishRegion(offset, patch, sizeof(patch)), MN_OK);
+    EXPECT_EQ(seen_offset, offset);
+    EXPECT_EQ(seen_size, sizeof(patch));
+    EXPECT_EQ(full_events, 1);
+
+    uint8_t slice[8] = {};
+    EXPECT_EQ(consumer->PullRegion("world", offset - 2, slice, sizeof(slice)), MN_INFO_CACHE_PULLED);
+    EXPECT_EQ(slice[1], 1);
+    EXPECT_EQ(slice[2], 9);
+    EXPECT_EQ(slice[5], 9);
+    EXPECT_EQ(slice[6], 1);
+
+    // 增量同步只拷贝脏块：镜像其余部分做了标记，不应被覆盖
+    memset(mirror.bytes, 7, MN_CONFIG_REGION_CHUNK);
+    EXPECT_EQ(consumer->PullDirty("world", &since, &mirror, sizeof(mirror)), MN_INFO_CACHE_PULLED);
+    EXPECT_EQ(since, 2u);
+    EXPECT_EQ(mirror.bytes[0], 7);
+    EXPECT_EQ(mirror.bytes[offset], 9);
+
+    // 越界与不支持的节点
+    EXPECT_EQ(world->PublishRegion(sizeof(World) - 2, patch, sizeof(patch)), MN_ERR_INVALID);
+    EXPECT_EQ(consumer->PullRegion("world", sizeof(World), slice, 1), MN_ERR_INVALID);
+    EXPECT_EQ(consumer->PublishRegion(0, patch, sizeof(patch)), MN_ERR_NOSUPPORT);
+}
+
+TEST_F(MycoNetTest, PullMany) {
+    NodeParam param = {};
+    param.size = sizeof(int);
+    param.conflags = CONF_CACHED;
+    auto a = net->NewNode("a", param);
+    auto b = net->NewNode("b", param);
+    auto c = net->NewNode("c", param);
+    auto reader = net->NewNode("reader", NodeParam{});
+
+    int va = 1, vb = 2;
+    a->Publish(&va, sizeof(va));
+    b->Publish(&vb, sizeof(vb));
+
+    int out[4] = {};
+    PullItem items[4] = {
+        {a->MyID(), &out[0], sizeof(int), 0, 0},
+        {b->MyID(), &out[1], sizeof(int), 0, 0},
+        {c->MyID(), &out[2], sizeof(int), 0, 0},
+        {12345, &out[3], sizeof(int), 0, 0},
+    };
+    // 单项失败不影响其他项
+    EXPECT_EQ(reader->PullMany(items, 4), MN_ERR_NOTFOUND);
+    EXPECT_EQ(items[0].status, MN_INFO_CACHE_PULLED);
+    EXPECT_EQ(out[0], 1);
+    EXPECT_EQ(out[1], 2);
+    EXPECT_EQ(items[2].seq, 0u);
+    EXPECT_EQ(items[3].status, MN_ERR_NOTFOUND);
+    EXPECT_EQ(reader->PullMany(items, 3, true), MN_OK);
+    EXPECT_EQ(items[1].seq, 1u);
+
+    // 发布者按 a、b、c 顺序写入同一计数；一致快照必然满足 a >= b >= c >= a - 1
+    int zero = 0;
+    for (auto &node : {a, b, c}) node->Publish(&zero, sizeof(zero));
+    std::atomic<bool> running{true};
+    std::thread writer([&]() {
+        for (int v = 1; running.load(); v++) {
+            a->Publish(&v, sizeof(v));
+            b->Publish(&v, sizeof(v));
+            c->Publish(&v, sizeof(v));
+        }
+    });
+    int busy = 0;
+    for (int i = 0; i < 2000; i++) {
+        int ret = reader->PullMany(items, 3, true);
+        if (ret == MN_ERR_BUSY) {
+            busy++;
+            continue;
+        }
+        ASSERT_EQ(ret, MN_OK);
+        EXPECT_GE(out[0], out[1]);
+        EXPECT_GE(out[1], out[2]);
+        EXPECT_GE(out[2], out[0] - 1);
+    }
+    running = false;
+    writer.join();
+    EXPECT_LT(busy, 2000);
+}
+
+TEST_F(MycoNetTest, Transaction) {
+    NodeParam param = {};
+    param.size = sizeof(int);
+    param.conflags = CONF_CACHED;
+    auto pose = net->NewNode("pose", param);
+    auto vel = net->NewNode("vel", param);
+    auto cov = net->NewNode("cov", param);
+
+    std::vector<std::pair<NodeID, NodeID>> events; // (sender, recver)
+    NodeParam sub_param = {};
+    sub_param.event_msk = EVENT_PUBLISH;
+    sub_param.event_cb = [&](const EventParam *p) { events.push_back({p->sender, p->recver}); };
+    auto s1 = net->NewNode("s1", sub_param);
+    auto s2 = net->NewNode("s2", sub_param);
+    for (auto &sub : {s1, s2})
+        for (auto name : {"pose", "vel", "cov"}) EXPECT_EQ(sub->Subscribe(name), MN_OK);
+
+    MycoNet::Transaction tx(*net);
+    int v = 1, w = 2;
+    EXPECT_EQ(tx.Publish(pose, &v, sizeof(v)), MN_OK);
+    EXPECT_EQ(tx.Publish(vel, &v, sizeof(v)), MN_OK);
+    EXPECT_EQ(tx.Publish(cov, &v, sizeof(v)), MN_OK);
+    EXPECT_EQ(tx.Publish(pose, &w, sizeof(w)), MN_OK); // 覆盖之前的暂存
+    EXPECT_EQ(tx.Publish(pose, &w, 2), MN_ERR_SIZE_MISMATCH);
+    EXPECT_EQ(tx.Size(), 3u);
+
+    // 提交前不可见
+    int out = 0;
+    EXPECT_EQ(s1->Pull("vel", &out, sizeof(out)), MN_INFO_CACHE_PULLED);
+    EXPECT_EQ(out, 0);
+    EXPECT_TRUE(events.empty());
+
+    EXPECT_EQ(tx.Commit(), MN_OK);
+    EXPECT_EQ(tx.Size(), 0u);
+    EXPECT_EQ(s1->Pull("pose", &out, sizeof(out)), MN_INFO_CACHE_PULLED);
+    EXPECT_EQ(out, 2);
+    // 一次分发：每个订阅者的事件连续送达
+    ASSERT_EQ(events.size(), 6u);
+    for (int i = 0; i < 3; i++) {
+        EXPECT_EQ(events[i].second, s1->MyID());
+        EXPECT_EQ(events[i + 3].second, s2->MyID());
+    }
+
+    // 并发提交与一致读取：读到的三个值必须来自同一个事务
+    s1->Unsubscribe("pose");
+    std::atomic<bool> running{true};
+    std::thread writer([&]() {
+        MycoNet::Transaction t(*net);
+        for (int i = 10; running.load(); i++) {
+            t.Publish(pose, &i, sizeof(i));
+            t.Publish(vel, &i, sizeof(i));
+            t.Publish(cov, &i, sizeof(i));
+            t.Commit();
+        }
+    });
+    int vals[3] = {};
+    PullItem items[3] = {
+        {pose->MyID(), &vals[0], sizeof(int), 0, 0},
+        {vel->MyID(), &vals[1], sizeof(int), 0, 0},
+        {cov->MyID(), &vals[2], sizeof(int), 0, 0},
+    };
+    for (int i = 0; i < 2000; i++) {
+        if (s1->PullMany(items, 3, true) != MN_OK) continue;
+        if (vals[0] < 10) continue;
+        EXPECT_EQ(vals[0], vals[1]);
+        EXPECT_EQ(vals[1], vals[2]);
+    }
+    running = false;
+    writer.join();
+}
+
+TEST_F(MycoNetTest, PullIfNewer) {
+    NodeParam param = {};
+    param.size = sizeof(int);
+    param.conflags = CONF_CACHED;
+    auto sensor = net->NewNode("sensor", param);
+    auto poller = net->NewNode("poller", NodeParam{});
+
+    uint64_t last = 0;
+    int out = -1;
+    EXPECT_EQ(poller->PullIfNewer("sensor", &last, &out, sizeof(out)), MN_ERR_NODATA);
+
+    int v = 5;
+    sensor->Publish(&v, sizeof(v));
+    int64_t stamp = 0;
+    EXPECT_EQ(poller->PullIfNewer("sensor", &last, &out, sizeof(out), 0, &stamp), MN_INFO_CACHE_PULLED);
+    EXPECT_EQ(out, 5);
+    EXPECT_EQ(last, 1u);
+    EXPECT_GT(stamp, 0);
+
+    // 无新数据时不拷贝
+    out = -1;
+    EXPECT_EQ(poller->PullIfNewer("sensor", &last, &out, sizeof(out)), MN_INFO_UNCHANGED);
+    EXPECT_EQ(out, -1);
+
+    // 序号跳变说明中间的样本被错过
+    for (v = 6; v <= 8; v++) sensor->Publish(&v, sizeof(v));
+    EXPECT_EQ(poller->PullIfNewer(sensor->MyID(), &last, &out, sizeof(out)), MN_INFO_CACHE_PULLED);
+    EXPECT_EQ(out, 8);
+    EXPECT_EQ(last, 4u);
+
+    // 超过 max_age 的数据视为过期
+    sensor->Publish(&v, sizeof(v));
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    EXPECT_EQ(poller->PullIfNewer("sensor", &last, &out, sizeof(out), 5), MN_ERR_STALE);
+    EXPECT_EQ(last, 4u);
+    EXPECT_EQ(poller->PullIfNewer("sensor", &last, &out, sizeof(out), 10000), MN_INFO_CACHE_PULLED);
+    EXPECT_STREQ(MycoNet::StrErrCode(MN_ERR_STALE), "Data too old");
+}
+
+TEST_F(MycoNetTest, VariableSizeCache) {
+    NodeParam param = {};
+    param.size = 1024; // 容量上限
+    param.conflags = static_cast<NodeFlag>(CONF_CACHED | CONF_VARSIZE);
+    auto cloud = net->NewNode("cloud", param);
+    auto reader = net->NewNode("reader", NodeParam{});
+
+    size_t len = 1;
+    EXPECT_EQ(reader->PeekSize("cloud", &len), MN_OK);
+    EXPECT_EQ(len, 0u);
+
+    const char msg[] = "hello";
+    EXPECT_EQ(cloud->Publish(msg, sizeof(msg)), MN_OK);
+    EXPECT_EQ(reader->PeekSize("cloud", &len), MN_OK);
+    EXPECT_EQ(len, sizeof(msg));
+
+    // 缓冲区只需不小于样本长度
+    char out[64] = {};
+    EXPECT_EQ(reader->Pull("cloud", out, sizeof(out), &len), MN_INFO_CACHE_PULLED);
+    EXPECT_EQ(len, sizeof(msg));
+    EXPECT_STREQ(out, "hello");
+    EXPECT_EQ(reader->Pull("cloud", out, 2, &len), MN_ERR_SIZE_MISMATCH);
+    EXPECT_EQ(len, sizeof(msg));
+
+    // 更长的样本，缓存随之增长，不超过容量
+    std::vector<uint8_t> big(600, 0xAB);
+    EXPECT_EQ(cloud->Publish(big.data(), big.size()), MN_OK);
+    std::vector<uint8_t> back(1024);
+    EXPECT_EQ(reader->Pull(cloud->MyID(), back.data(), back.size(), &len), MN_INFO_CACHE_PULLED);
+    EXPECT_EQ(len, 600u);
+    EXPECT_EQ(back[599], 0xAB);
+    std::vector<uint8_t> huge(1025);
+    EXPECT_EQ(cloud->Publish(huge.data(), huge.size()), MN_ERR_SIZE_MISMATCH);
+
+    // 视图接口：原地读取，不拷贝
+    size_t view_size = 0;
+    uint8_t first = 0;
+    EXPECT_EQ(reader->Pull0("cloud", [&](const void *data_p, size_t size) {
+        view_size = size;
+        first = *static_cast<const uint8_t *>(data_p);
+    }), MN_INFO_CACHE_PULLED);
+    EXPECT_EQ(view_size, 600u);
+    EXPECT_EQ(first, 0xAB);
+
+    // 事务中的变长发布
+    MycoNet::Transaction tx(*net);
+    EXPECT_EQ(tx.Publish(cloud, msg, 3), MN_OK);
+    EXPECT_EQ(tx.Commit(), MN_OK);
+    EXPECT_EQ(reader->PeekSize("cloud", &len), MN_OK);
+    EXPECT_EQ(len, 3u);
+}
+
+TEST_F(MycoNetTest, LatchedDeliveryUnlocked) {
+    NodeParam param = {};
+    param.size = sizeof(int);
+    param.conflags = (NodeFlag)(CONF_CACHED | CONF_LATCHED);
+    auto state_node = net->NewNode("state", param);
+    int v = 7;
+    state_node->Publish(&v, sizeof(v));
+
+    // 回调里向同一节点发布：回调期间不再持有缓存锁，不会死锁
+    int latched_value = 0;
+    NodeParam sub_param = {};
+    sub_param.event_msk = EVENT_LATCHED;
+    sub_param.event_cb = [&](const EventParam *p) {
+        latched_value = *static_cast<int *>(p->data_p);
+        int next = latched_value + 1;
+        EXPECT_EQ(state_node->Publish(&next, sizeof(next)), MN_OK);
+    };
+    auto sub = net->NewNode("sub", sub_param);
+    EXPECT_EQ(sub->Subscribe("state"), MN_OK);
+    EXPECT_EQ(latched_value, 7);
+    int out = 0;
+    EXPECT_EQ(sub->Pull("state", &out, sizeof(out)), MN_INFO_CACHE_PULLED);
+    EXPECT_EQ(out, 8);
+
+    // 等待中的订阅在节点创建时一并获得同一份快照
+    std::vector<NodeID> got;
+    NodeParam late_param = {};
+    late_param.event_msk = EVENT_LATCHED;
+    late_param.event_cb = [&](const EventParam *p) {
+        EXPECT_EQ(p->size, sizeof(int));
+        got.push_back(p->recver);
+    };
+    auto w1 = net->NewNode("w1", late_param);
+    auto w2 = net->NewNode("w2", late_param);
+    EXPECT_EQ(w1->Subscribe("late"), MN_INFO_PENDING);
+    EXPECT_EQ(w2->Subscribe("late"), MN_INFO_PENDING);
+    auto late = net->NewNode("late", param);
+    ASSERT_EQ(got.size(), 2u);
+    EXPECT_EQ(late->SubNum(), 2);
+}
+
+TEST_F(MycoNetTest, ParallelFanout) {
+    EXPECT_EQ(net->StartFanout(3), MN_OK);
+    EXPECT_EQ(net->StartFanout(3), MN_ERR_INITIALIZED);
+
+    NodeParam param = {};
+    param.size = sizeof(int);
+    param.fanout_threshold = 8;
+    auto waiting = net->NewNode("waiting", param);
+    param.fanout_wait = false;
+    auto detached = net->NewNode("detached", param);
+
+    std::atomic<int> calls{0};
+    std::atomic<int> sum{0};
+    NodeParam sub_param = {};
+    sub_param.event_msk = EVENT_PUBLISH;
+    sub_param.event_cb = [&](const EventParam *p) {
+        sum += *static_cast<int *>(p->data_p);
+        calls++;
+    };
+    std::vector<std::shared_ptr<MycoNode>> subs;
+    for (int i = 0; i < 64; i++) {
+        subs.push_back(net->NewNode("sub" + std::to_string(i), sub_param));
+        subs.back()->Subscribe("waiting");
+        subs.back()->Subscribe("detached");
+    }
+
+    // 等待模式：Publish 返回时所有回调都已执行
+    int v = 1;
+    EXPECT_EQ(waiting->Publish(&v, sizeof(v)), MN_OK);
+    EXPECT_EQ(calls.load(), 64);
+    EXPECT_EQ(sum.load(), 64);
+
+    // 非等待模式：回调读取的是副本，发布方可立即改写自己的缓冲区
+    v = 2;
+    EXPECT_EQ(detached->Publish(&v, sizeof(v)), MN_OK);
+    v = 100;
+    for (int i = 0; i < 1000 && calls.load() < 128; i++)
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    EXPECT_EQ(calls.load(), 128);
+    EXPECT_EQ(sum.load(), 64 + 128);
+}
+
+TEST_F(MycoNetTest, ConsumerGroups) {
+    NodeParam param = {};
+    param.size = sizeof(int);
+    auto jobs = net->NewNode("jobs", param);
+
+    std::map<NodeID, int> handled;
+    int plain_seen = 0;
+    NodeParam sub_param = {};
+    sub_param.event_msk = EVENT_PUBLISH;
+    sub_param.event_cb = [&](const EventParam *p) { handled[p->recver]++; };
+    std::vector<std::shared_ptr<MycoNode>> workers;
+    for (int i = 0; i < 3; i++) {
+        workers.push_back(net->NewNode("worker" + std::to_string(i), sub_param));
+        EXPECT_EQ(workers.back()->Subscribe("jobs", "pool"), MN_OK);
+    }
+    NodeParam plain_param = {};
+    plain_param.event_msk = EVENT_PUBLISH;
+    plain_param.event_cb = [&](const EventParam *) { plain_seen++; };
+    auto monitor = net->NewNode("monitor", plain_param);
+    EXPECT_EQ(monitor->Subscribe("jobs"), MN_OK);
+    EXPECT_EQ(jobs->SubNum(), 4);
+
+    // 同一目标只能有一种订阅方式
+    EXPECT_EQ(workers[0]->Subscribe("jobs", "pool"), MN_OK);
+    EXPECT_EQ(workers[0]->Subscribe("jobs", "other"), MN_ERR_EXIST);
+    EXPECT_EQ(workers[0]->Subscribe("jobs"), MN_ERR_EXIST);
+    EXPECT_EQ(monitor->Subscribe("jobs", "pool"), MN_ERR_EXIST);
+
+    // 组内轮询，每条消息只给一个成员；普通订阅者收到全部
+    int v = 0;
+    for (int i = 0; i < 30; i++) jobs->Publish(&v, sizeof(v));
+    EXPECT_EQ(plain_seen, 30);
+    for (auto &w : workers) EXPECT_EQ(handled[w->MyID()], 10);
+
+    // 成员退出、移除后由剩余成员分担
+    EXPECT_EQ(workers[0]->Unsubscribe("jobs"), MN_OK);
+    net->RemoveNode(workers[1]->MyID());
+    handled.clear();
+    for (int i = 0; i < 4; i++) jobs->Publish(&v, sizeof(v));
+    EXPECT_EQ(handled.size(), 1u);
+    EXPECT_EQ(handled[workers[2]->MyID()], 4);
+    EXPECT_EQ(jobs->SubNum(), 2);
+
+    // 等待中的组订阅在节点创建后生效；最少负载策略
+    auto late_a = net->NewNode("late_a", sub_param);
+    auto late_b = net->NewNode("late_b", sub_param);
+    EXPECT_EQ(late_a->Subscribe("later", "g", GroupPolicy::LEAST_LOADED), MN_INFO_PENDING);
+    EXPECT_EQ(late_b->Subscribe("later", "g"), MN_INFO_PENDING);
+    auto later = net->NewNode("later", param);
+    handled.clear();
+    for (int i = 0; i < 6; i++) later->Publish(&v, sizeof(v));
+    EXPECT_EQ(handled[late_a->MyID()] + handled[late_b->MyID()], 6);
+    EXPECT_GT(handled[late_a->MyID()], 0);
+    EXPECT_GT(handled[late_b->MyID()], 0);
+}
+
+TEST_F(MycoNetTest, KeyedPartitions) {
+    NodeParam param = {};
+    param.size = sizeof(int);
+    param.partitions = 32;
+    auto tracks = net->NewNode("tracks", param);
+
+    std::map<uint64_t, NodeID> route; // key -> 最近一次处理它的成员
+    uint64_t current_key = 0;
+    NodeParam sub_param = {};
+    sub_param.event_msk = EVENT_PUBLISH;
+    sub_param.event_cb = [&](const EventParam *p) { route[current_key] = p->recver; };
+    std::vector<std::shared_ptr<MycoNode>> workers;
+    auto add_worker = [&](const std::string &name) {
+        workers.push_back(net->NewNode(name, sub_param));
+        EXPECT_EQ(workers.back()->Subscribe("tracks", "trackers"), MN_OK);
+    };
+    auto publish_all = [&]() {
+        int v = 0;
+        for (current_key = 0; current_key < 200; current_key++)
+            EXPECT_EQ(tracks->Publish(&v, sizeof(v), current_key), MN_OK);
+        return route;
+    };
+    for (int i = 0; i < 4; i++) add_worker("w" + std::to_string(i));
+
+    // 同一个键总是落到同一个成员上
+    auto before = publish_all();
+    EXPECT_EQ(publish_all(), before);
+    std::set<NodeID> used;
+    for (auto &kv : before) used.insert(kv.second);
+    EXPECT_EQ(used.size(), 4u);
+
+    // 移除成员：只有它负责的键会迁移
+    const NodeID gone = workers[1]->MyID();
+    net->RemoveNode(gone);
+    auto after_remove = publish_all();
+    for (auto &kv : before) {
+        if (kv.second != gone) {
+            EXPECT_EQ(after_remove[kv.first], kv.second);
+        } else {
+            EXPECT_NE(after_remove[kv.first], gone);
+        }
+    }
+
+    // 新增成员：迁移的键只会迁到新成员
+    add_worker("w4");
+    auto after_add = publish_all();
+    for (auto &kv : after_remove) {
+        if (after_add[kv.first] != kv.second) {
+            EXPECT_EQ(after_add[kv.first], workers.back()->MyID());
+        }
+    }
+}
+
+TEST_F(MycoNetTest, ContentFilter) {
+    struct Msg {
+        uint16_t type;
+        uint16_t flags;
+        uint32_t value;
+    };
+    NodeParam param = {};
+    param.size = sizeof(Msg);
+    param.conflags = CONF_CACHED;
+    auto bus = net->NewNode("bus", param);
+
+    std::map<NodeID, std::vector<uint32_t>> got;
+    NodeParam sub_param = {};
+    sub_param.event_msk = EVENT_PUBLISH;
+    sub_param.event_cb = [&](const EventParam *p) {
+        got[p->recver].push_back(static_cast<const Msg *>(p->data_p)->value);
+    };
+    auto all = net->NewNode("all", sub_param);
+    auto type2 = net->NewNode("type2", sub_param);
+    auto flagged = net->NewNode("flagged", sub_param);
+    auto big = net->NewNode("big", sub_param);
+    EXPECT_EQ(all->Subscribe("bus"), MN_OK);
+    FilterRule rule = {offsetof(Msg, type), 2, FilterRule::EQ, 2};
+    EXPECT_EQ(type2->Subscribe("bus", rule), MN_OK);
+    // 掩码规则：flags 的第 0 位被置位
+    FilterRule bit = {offsetof(Msg, flags), 2, FilterRule::NE, 0, 0x1};
+    EXPECT_EQ(flagged->Subscribe("bus", bit), MN_OK);
+    EXPECT_EQ(big->Subscribe("bus", [](const void *data_p, size_t size) {
+        return size == sizeof(Msg) && static_cast<const Msg *>(data_p)->value >= 3;
+    }), MN_OK);
+    FilterRule bad = {0, 3, FilterRule::EQ, 0};
+    EXPECT_EQ(all->Subscribe("bus", bad), MN_ERR_INVALID);
+
+    const Msg msgs[] = {{1, 0, 0}, {2, 1, 1}, {2, 0, 2}, {3, 3, 3}, {2, 2, 4}};
+    for (const Msg &m : msgs) EXPECT_EQ(bus->Publish(&m, sizeof(m)), MN_OK);
+    EXPECT_EQ(got[all->MyID()], (std::vector<uint32_t>{0, 1, 2, 3, 4}));
+    EXPECT_EQ(got[type2->MyID()], (std::vector<uint32_t>{1, 2, 4}));
+    EXPECT_EQ(got[flagged->MyID()], (std::vector<uint32_t>{1, 3}));
+    EXPECT_EQ(got[big->MyID()], (std::vector<uint32_t>{3, 4}));
+
+    // 事务提交同样先过滤
+    got.clear();
+    {
+        MycoNet::Transaction tx(*net);
+        const Msg m = {2, 0, 7};
+        EXPECT_EQ(tx.Publish(bus, &m, sizeof(m)), MN_OK);
+        EXPECT_EQ(tx.Commit(), MN_OK);
+    }
+    EXPECT_EQ(got[type2->MyID()], (std::vector<uint32_t>{7}));
+    EXPECT_TRUE(got[flagged->MyID()].empty());
+
+    // 重新订阅会替换过滤条件，取消订阅后不再收到
+    got.clear();
+    EXPECT_EQ(type2->Subscribe("bus"), MN_OK);
+    EXPECT_EQ(flagged->Unsubscribe("bus"), MN_OK);
+    const Msg m = {1, 1, 9};
+    EXPECT_EQ(bus->Publish(&m, sizeof(m)), MN_OK);
+    EXPECT_EQ(got[type2->MyID()], (std::vector<uint32_t>{9}));
+    EXPECT_TRUE(got[flagged->MyID()].empty());
+    EXPECT_EQ(got[all->MyID()], (std::vector<uint32_t>{9}));
+    EXPECT_EQ(got[big->MyID()], (std::vector<uint32_t>{9}));
+
+    // 先订阅后创建的发布者也带上过滤条件
+    auto late = net->NewNode("late_sub", sub_param);
+    EXPECT_EQ(late->Subscribe("late_bus", rule), MN_INFO_PENDING);
+    auto late_bus = net->NewNode("late_bus", param);
+    for (const Msg &msg : msgs) EXPECT_EQ(late_bus->Publish(&msg, sizeof(msg)), MN_OK);
+    EXPECT_EQ(got[late->MyID()], (std::vector<uint32_t>{1, 2, 4}));
+
+    // 并行分发同样按位图过滤，订阅者超过 64 个时跨多个字
+    EXPECT_EQ(net->StartFanout(2), MN_OK);
+    param.conflags = CONF_NONE;
+    param.fanout_threshold = 4;
+    auto waiting = net->NewNode("fan_wait", param);
+    param.fanout_wait = false;
+    auto detached = net->NewNode("fan_detached", param);
+    std::atomic<int> calls{0};
+    std::atomic<uint32_t> sum{0};
+    NodeParam fan_param = {};
+    fan_param.event_msk = EVENT_PUBLISH;
+    fan_param.event_cb = [&](const EventParam *p) {
+        sum += static_cast<const Msg *>(p->data_p)->value;
+        calls++;
+    };
+    std::vector<std::shared_ptr<MycoNode>> subs;
+    for (uint16_t i = 0; i < 100; i++) {
+        subs.push_back(net->NewNode("fan" + std::to_string(i), fan_param));
+        const FilterRule odd = {offsetof(Msg, type), 2, FilterRule::EQ, (uint64_t)(i % 2)};
+        EXPECT_EQ(subs.back()->Subscribe("fan_wait", odd), MN_OK);
+        EXPECT_EQ(subs.back()->Subscribe("fan_detached", odd), MN_OK);
+    }
+    Msg fan = {1, 0, 1};
+    EXPECT_EQ(waiting->Publish(&fan, sizeof(fan)), MN_OK);
+    EXPECT_EQ(calls.load(), 50);
+    fan = {0, 0, 2};
+    EXPECT_EQ(detached->Publish(&fan, sizeof(fan)), MN_OK);
+    fan.value = 100;
+    for (int i = 0; i < 1000 && calls.load() < 100; i++)
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    EXPECT_EQ(calls.load(), 100);
+    EXPECT_EQ(sum.load(), 50u + 100u);
+}
+
+TEST_F(MycoNetTest, SingleThreadedInstance) {
+    MycoNet::DelInst("single");
+    auto single = MycoNet::GetInst("single", Threading::SINGLE);
+    EXPECT_EQ(single->GetThreading(), Threading::SINGLE);
+    // 已存在的实例不受后续参数影响
+    EXPECT_EQ(MycoNet::GetInst("single", Threading::SHARED), single);
+    EXPECT_EQ(single->GetThreading(), Threading::SINGLE);
+    EXPECT_EQ(net->GetThreading(), Threading::SHARED);
+
+    NodeParam param = {};
+    param.size = sizeof(int);
+    param.conflags = CONF_CACHED;
+    auto sensor = single->NewNode("sensor", param);
+    const NodeID sensor_id = sensor->MyID();
+
+    // 回调中移除发布者和其他订阅者，已借出的节点要等发布结束才释放
+    int received = 0;
+    NodeParam sub_param = {};
+    sub_param.event_msk = EVENT_PUBLISH;
+    sub_param.event_cb = [&](const EventParam *p) {
+        received += *static_cast<int *>(p->data_p);
+        single->RemoveNode("sub_b");
+        single->RemoveNode(p->sender);
+    };
+    auto sub_a = single->NewNode("sub_a", sub_param);
+    auto sub_b = single->NewNode("sub_b", sub_param);
+    EXPECT_EQ(sub_a->Subscribe("sensor"), MN_OK);
+    EXPECT_EQ(sub_b->Subscribe("sensor"), MN_OK);
+
+    // 只剩注册表持有 sensor 和 sub_b
+    MycoNode *sensor_raw = sensor.get();
+    sensor.reset();
+    sub_b.reset();
+    int value = 7;
+    EXPECT_EQ(sensor_raw->Publish(&value, sizeof(value)), MN_OK);
+    int pulled = 0;
+    EXPECT_EQ(sub_a->Pull(sensor_id, &pulled, sizeof(pulled)), MN_ERR_NOTFOUND);
+
+    auto probe = single->NewNode("probe", NodeParam{});
+    EXPECT_EQ(received, 7);
+    EXPECT_EQ(single->NodeNum(), 2);
+    EXPECT_EQ(sub_a->PubNum(), 0);
+
+    // 重新建立后缓存读取照常
+    auto sensor2 = single->NewNode("sensor", param);
+    value = 9;
+    sensor2->Publish(&value, sizeof(value));
+    EXPECT_EQ(probe->Pull("sensor", &pulled, sizeof(pulled)), MN_INFO_CACHE_PULLED);
+    EXPECT_EQ(pulled, 9);
+
+    // 单线程实例上 PullNext 不等待：有新样本直接取走，否则立即超时
+    EXPECT_EQ(probe->PullNext("sensor", &pulled, sizeof(pulled)), MN_INFO_CACHE_PULLED);
+    EXPECT_EQ(pulled, 9);
+    EXPECT_EQ(probe->PullNext("sensor", &pulled, sizeof(pulled)), MN_ERR_TIMEOUT);
+    EXPECT_EQ(probe->PullNext("sensor", &pulled, sizeof(pulled), 1000), MN_ERR_TIMEOUT);
+
+    // 单线程实例的消费组计数不用原子读改写，轮转和负载均衡照常
+    std::vector<NodeID> handled;
+    std::shared_ptr<MycoNode> jobs;
+    NodeParam worker_param = {};
+    worker_param.event_msk = EVENT_PUBLISH;
+    worker_param.event_cb = [&](const EventParam *p) {
+        handled.push_back(p->recver);
+        // 回调中再次发布，正忙的成员不会被选中
+        if (handled.size() == 1) jobs->Publish(p->data_p, p->size);
+    };
+    jobs = single->NewNode("jobs", param);
+    auto worker_a = single->NewNode("worker_a", worker_param);
+    auto worker_b = single->NewNode("worker_b", worker_param);
+    EXPECT_EQ(worker_a->Subscribe("jobs", "pool", GroupPolicy::LEAST_LOADED), MN_OK);
+    EXPECT_EQ(worker_b->Subscribe("jobs", "pool", GroupPolicy::LEAST_LOADED), MN_OK);
+    EXPECT_EQ(jobs->Publish(&value, sizeof(value)), MN_OK);
+    ASSERT_EQ(handled.size(), 2u);
+    EXPECT_NE(handled[0], handled[1]);
+    for (int i = 0; i < 4; i++) EXPECT_EQ(jobs->Publish(&value, sizeof(value)), MN_OK);
+    EXPECT_EQ(std::count(handled.begin(), handled.end(), worker_a->MyID()), 3);
+    EXPECT_EQ(std::count(handled.begin(), handled.end(), worker_b->MyID()), 3);
+    MycoNet::DelInst("single");
+}
+
+TEST_F(MycoNetTest, PullNextWaitsForPublish) {
+    NodeParam cached_param = {};
+    cached_param.size = sizeof(int);
+    cached_param.conflags = CONF_CACHED;
+    auto cached_node = net->NewNode("cached_node", cached_param);
+
+    NodeParam puller_param = {};
+    auto puller = net->NewNode("puller", puller_param);
+
+    // 尚未发布过数据，超时返回
+    int result = 0;
+    EXPECT_EQ(puller->PullNext("cached_node", &result, sizeof(result), 10), MN_ERR_TIMEOUT);
+
+    // 另一线程发布后被唤醒
+    std::thread publisher([&]() {
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        int data = 789;
+        cached_node->Publish(&data, sizeof(data));
+    });
+    EXPECT_EQ(puller->PullNext("cached_node", &result, sizeof(result), 1000), MN_INFO_CACHE_PULLED);
+    EXPECT_EQ(result, 789);
+    publisher.join();
+
+    // 同一样本不会被重复取到
+    EXPECT_EQ(puller->PullNext(cached_node->MyID(), &result, sizeof(result), 0), MN_ERR_TIMEOUT);
+
+    // 错误条件
+    EXPECT_EQ(puller->PullNext("cached_node", &result, 1, 0), MN_ERR_SIZE_MISMATCH);
+    EXPECT_EQ(puller->PullNext("puller", &result, sizeof(result), 0), MN_ERR_NOSUPPORT);
+    EXPECT_EQ(puller->PullNext("nonexistent", &result, sizeof(result), 0), MN_ERR_NOTFOUND);
+}
+
+TEST_F(MycoNetTest, PullNextWakesOnRemove) {
+    NodeParam cached_param = {};
+    cached_param.size = sizeof(int);
+    cached_param.conflags = CONF_CACHED;
+    auto cached_node = net->NewNode("cached_node", cached_param);
+
+    NodeParam puller_param = {};
+    auto puller = net->NewNode("puller", puller_param);
+
+    std::thread remover([&]() {
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        net->RemoveNode("cached_node");
+    });
+    int result = 0;
+    EXPECT_EQ(puller->PullNext("cached_node", &result, sizeof(result)), MN_ERR_NOTFOUND);
+    remover.join();
+}
+
+// ====================================================================
+// 内存池测试
+// ====================================================================
+TEST_F(MycoNetTest, PoolReusesBlocks) {
+    MsgPool &pool = net->Pool();
+
+    Buffer buf1 = pool.Alloc(100);
+    ASSERT_TRUE(buf1);
+    EXPECT_EQ(buf1.Size(), 100u);
+    EXPECT_GE(buf1.Capacity(), 100u);
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(buf1.Data()) % 64, 0u);
+
+    // 释放后再申请同尺寸，复用同一块内存
+    uint8_t *first = buf1.Data();
+    buf1.Reset();
+    Buffer buf2 = pool.Alloc(100);
+    EXPECT_EQ(buf2.Data(), first);
+
+    // 超出容量的 Resize 失败
+    EXPECT_EQ(buf2.Resize(buf2.Capacity() + 1), MN_ERR_SIZE_MISMATCH);
+    EXPECT_EQ(buf2.Resize(10), MN_OK);
+
+    // 移动语义
+    Buffer buf3 = std::move(buf2);
+    EXPECT_FALSE(buf2);
+    EXPECT_EQ(buf3.Data(), first);
+}
+
+TEST_F(MycoNetTest, PoolClassesFromNodesAndReserve) {
+    NodeParam param = {};
+    param.size = 3000;
+    param.conflags = CONF_CACHED;
+    auto node = net->NewNode("big_node", param);
+
+    // 节点尺寸注册为精确尺寸类，而不是向上取整到 4096
+    Buffer loan = node->Loan();
+    ASSERT_TRUE(loan);
+    EXPECT_EQ(loan.Size(), 3000u);
+    EXPECT_LT(loan.Capacity(), 4096u);
+    loan.Reset();
+
+    // 预留后稳态申请不再触发 malloc
+    const size_t COUNT = 64;
+    EXPECT_EQ(net->ReservePool(COUNT), MN_OK);
+    size_t heap_allocs = net->Pool().HeapAllocs();
+    std::vector<Buffer> loans;
+    for (size_t i = 0; i < COUNT; ++i) loans.push_back(node->Loan());
+    loans.clear();
+    for (size_t i = 0; i < COUNT; ++i) loans.push_back(node->Loan());
+    EXPECT_EQ(net->Pool().HeapAllocs(), heap_allocs);
+
+    // 高水位统计
+    std::vector<PoolStats> stats;
+    net->Pool().Stats(stats);
+    bool found = false;
+    for (const auto &st : stats) {
+        if (st.block_size == loans.front().Capacity()) {
+            found = true;
+            EXPECT_EQ(st.in_use, COUNT);
+            EXPECT_EQ(st.high_water, COUNT);
+            EXPECT_GE(st.total, COUNT);
+        }
+    }
+    EXPECT_TRUE(found);
+}
+
+TEST_F(MycoNetTest, PoolCrossThreadFree) {
+    const int NUM_BUFFERS = 1000;
+    std::vector<Buffer> buffers;
+    for (int i = 0; i < NUM_BUFFERS; ++i) {
+        buffers.push_back(net->Pool().Alloc(256));
+        ASSERT_TRUE(buffers.back());
+        memset(buffers.back().Data(), i & 0xFF, 256);
+    }
+    // 在其他线程释放，块回到全局空闲链表
+    std::thread releaser([&]() { buffers.clear(); });
+    releaser.join();
+
+    std::vector<PoolStats> stats;
+    net->Pool().Stats(stats);
+    for (const auto &st : stats) EXPECT_EQ(st.in_use, 0u);
+}
+
+TEST_F(MycoNetTest, CachePlacement) {
+    // 大页映射：按 2MB 对齐分配，初始内容为零
+    Buffer huge = MsgPool::AllocPlaced(3 << 20, 0, true);
+    ASSERT_TRUE(huge);
+    EXPECT_EQ(huge.Capacity() % (2 << 20), 0u);
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(huge.Data()) % 64, 0u);
+    EXPECT_EQ(huge.Data()[huge.Size() - 1], 0);
+
+    // 绑定到发布者所在节点的缓存，收发行为不变
+    const size_t FRAME_SIZE = 4 << 20;
+    NodeParam param = {};
+    param.size = FRAME_SIZE;
+    param.conflags = CONF_CACHED;
+    param.numa_node = NUMA_PUBLISHER;
+    param.huge_pages = true;
+    auto camera = net->NewNode("camera", param);
+
+    std::vector<uint8_t> frame(FRAME_SIZE, 0x5A), out(FRAME_SIZE);
+    EXPECT_EQ(camera->Publish(frame.data(), frame.size()), MN_OK);
+    auto viewer = net->NewNode("viewer", NodeParam{});
+    EXPECT_EQ(viewer->Pull("camera", out.data(), out.size()), MN_INFO_CACHE_PULLED);
+    EXPECT_EQ(out, frame);
+
+    Buffer loan = camera->Loan();
+    ASSERT_TRUE(loan);
+    EXPECT_EQ(loan.Size(), FRAME_SIZE);
+}
+
 // ====================================================================
 // 错误处理和边界条件测试
 // ====================================================================
@@ -374,6 +1433,45 @@ TEST_F(MycoNetTest, ThreadSafetyNodeCreation) {
     EXPECT_EQ(net->NodeNum(), NUM_THREADS * OPERATIONS_PER_THREAD);
 }
 
+TEST_F(MycoNetTest, ThreadSafetyParallelWiring) {
+    const int NUM_THREADS = 8;
+    const int OPERATIONS_PER_THREAD = 100;
+
+    std::vector<std::thread> threads;
+    std::atomic<int> failures{0};
+
+    // 每个线程独立地创建、连接、发布并移除自己的节点对
+    for (int i = 0; i < NUM_THREADS; ++i) {
+        threads.emplace_back([&, i]() {
+            for (int j = 0; j < OPERATIONS_PER_THREAD; ++j) {
+                std::string suffix = std::to_string(i) + "_" + std::to_string(j);
+                int received = 0;
+                NodeParam sub_param = {};
+                sub_param.event_msk = EVENT_PUBLISH;
+                sub_param.event_cb = [&](const EventParam*) { received++; };
+                auto sub = net->NewNode("wire_sub_" + suffix, sub_param);
+
+                // 先订阅（挂起），再创建发布者
+                if (sub->Subscribe("wire_pub_" + suffix) != MN_INFO_PENDING) failures++;
+                auto pub = net->NewNode("wire_pub_" + suffix, NodeParam{});
+                int data = j;
+                pub->Publish(&data, sizeof(data));
+                if (received != 1 || pub->SubNum() != 1 || sub->PubNum() != 1) failures++;
+
+                net->RemoveNode(pub->MyID());
+                if (sub->PubNum() != 0) failures++;
+                net->RemoveNode(sub->MyID());
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    EXPECT_EQ(failures, 0);
+    EXPECT_EQ(net->NodeNum(), 0);
+}
+
 TEST_F(MycoNetTest, ThreadSafetySubscribeUnsubscribe) {
     const int NUM_THREADS = 6;
     const int OPERATIONS_PER_THREAD = 100;
@@ -0,0 +1,154 @@
+/**
+ * legacy C 核心的静态分配模式测试 (MN_CONF_STATIC_ALLOC=1)
+ *
+ *   make ctest-legacy-static && ./bin/ctest-legacy-static
+ *
+ * 链接时用 -Wl,--wrap 截获核心代码里的 malloc/calloc/realloc，
+ * 以确认 MycoNet_Init 之后的所有操作都不再走堆分配。
+ */
+#include "../3rd_party/unity/unity.h"
+#include "myconet.h"
+#include "myconet_conf.h"
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <stdatomic.h>
+
+// ====================================================================
+// malloc 截获
+// ====================================================================
+static atomic_int g_heap_calls = 0;
+
+void *__real_malloc(size_t size);
+void *__real_calloc(size_t num, size_t size);
+void *__real_realloc(void *ptr, size_t size);
+
+void *__wrap_malloc(size_t size) {
+    atomic_fetch_add(&g_heap_calls, 1);
+    return __real_malloc(size);
+}
+
+void *__wrap_calloc(size_t num, size_t size) {
+    atomic_fetch_add(&g_heap_calls, 1);
+    return __real_calloc(num, size);
+}
+
+void *__wrap_realloc(void *ptr, size_t size) {
+    atomic_fetch_add(&g_heap_calls, 1);
+    return __real_realloc(ptr, size);
+}
+
+// ====================================================================
+// 测试节点
+// ====================================================================
+static MycoNode_t s_nodes[MN_CONF_MAX_NODES];
+static int g_publish_count = 0;
+
+static int test_event_cb(MycoNode_t *node_p, EventParam_t *param) {
+    (void)node_p;
+    if (param->event == EVENT_PUBLISH) g_publish_count++;
+    return MN_OK;
+}
+
+static void setup_node(MycoNode_t *node_p, const char *name, uint32_t size, NodeConf_t conf) {
+    memset(node_p, 0, sizeof(*node_p));
+    snprintf(node_p->name, sizeof(node_p->name), "%s", name);
+    node_p->size = size;
+    node_p->conflags = conf;
+    node_p->event_msk = EVENT_PUBLISH | EVENT_PULL;
+    node_p->event_cb = test_event_cb;
+}
+
+void setUp(void) {
+    g_publish_count = 0;
+    TEST_ASSERT_EQUAL_INT(MN_OK, MycoNet_Init());
+    atomic_store(&g_heap_calls, 0);
+}
+
+void tearDown(void) {
+    for (int i = 0; i < MN_CONF_MAX_NODES; i++) {
+        MycoNet_DeinitNode(&s_nodes[i]);
+    }
+    MycoNet_Deinit();
+}
+
+// ====================================================================
+// 测试用例
+// ====================================================================
+void test_static_no_heap_after_init(void) {
+    MycoNode_t *pub = &s_nodes[0];
+    MycoNode_t *sub = &s_nodes[1];
+    setup_node(pub, "pub", sizeof(int), CONF_CACHED);
+    setup_node(sub, "sub", 0, CONF_NONE);
+
+    // 节点注册、订阅、发布、拉取、取消订阅、移除，全程不应调用 malloc
+    for (int round = 0; round < 100; round++) {
+        TEST_ASSERT_EQUAL_INT(MN_OK, MycoNet_InitNode(pub));
+        TEST_ASSERT_EQUAL_INT(MN_OK, MycoNet_InitNode(sub));
+        TEST_ASSERT_EQUAL_INT(MN_OK, MycoNet_PushBackNode(pub));
+        TEST_ASSERT_EQUAL_INT(MN_OK, MycoNet_PushBackNode(sub));
+        TEST_ASSERT_EQUAL_INT(MN_OK, MycoNet_NodeSubscribe(sub, "pub"));
+
+        int value = round;
+        TEST_ASSERT_EQUAL_INT(MN_OK, MycoNet_NodePublish(pub, &value, sizeof(value)));
+        int pulled = -1;
+        TEST_ASSERT_EQUAL_INT(MN_OK, MycoNet_NodePull(sub, "pub", &pulled, sizeof(pulled)));
+        TEST_ASSERT_EQUAL_INT(round, pulled);
+
+        TEST_ASSERT_EQUAL_INT(MN_OK, MycoNet_NodeUnsubscribe(sub, "pub"));
+        TEST_ASSERT_EQUAL_INT(MN_OK, MycoNet_DeinitNode(sub));
+        TEST_ASSERT_EQUAL_INT(MN_OK, MycoNet_DeinitNode(pub));
+    }
+
+    TEST_ASSERT_EQUAL_INT(100, g_publish_count);
+    TEST_ASSERT_EQUAL_INT(0, atomic_load(&g_heap_calls));
+}
+
+void test_static_pool_exhaustion(void) {
+    char name[MN_NODE_NAME_MAX_LEN];
+
+    // 节点槽位：dummy 节点已占用一个
+    for (int i = 0; i < MN_CONF_MAX_NODES - 1; i++) {
+        snprintf(name, sizeof(name), "node%d", i);
+        setup_node(&s_nodes[i], name, 0, CONF_NONE);
+        TEST_ASSERT_EQUAL_INT(MN_OK, MycoNet_InitNode(&s_nodes[i]));
+        TEST_ASSERT_EQUAL_INT(MN_OK, MycoNet_PushBackNode(&s_nodes[i]));
+    }
+    MycoNode_t *extra = &s_nodes[MN_CONF_MAX_NODES - 1];
+    setup_node(extra, "extra", 0, CONF_NONE);
+    TEST_ASSERT_EQUAL_INT(MN_OK, MycoNet_InitNode(extra));
+    TEST_ASSERT_EQUAL_INT(MN_ERR_NOMEM, MycoNet_PushBackNode(extra));
+    TEST_ASSERT_NULL(MycoNet_SearchNode("extra"));
+
+    // 移除一个节点后槽位可复用
+    TEST_ASSERT_EQUAL_INT(MN_OK, MycoNet_RemoveNode(&s_nodes[0]));
+    TEST_ASSERT_EQUAL_INT(MN_OK, MycoNet_PushBackNode(extra));
+    TEST_ASSERT_TRUE(MycoNet_SearchNode("extra") == extra);
+
+    // 订阅者数量上限
+    for (int i = 1; i <= MN_CONF_MAX_SUBS; i++) {
+        TEST_ASSERT_EQUAL_INT(MN_OK, MycoNet_NodeSubscribe(&s_nodes[i], "extra"));
+    }
+    TEST_ASSERT_EQUAL_INT(MN_ERR_NOMEM, MycoNet_NodeSubscribe(&s_nodes[MN_CONF_MAX_SUBS + 1], "extra"));
+    TEST_ASSERT_EQUAL_INT(MN_CONF_MAX_SUBS, MycoNet_GetNodePubNum(extra));
+    TEST_ASSERT_EQUAL_INT(0, MycoNet_GetNodeSubNum(&s_nodes[MN_CONF_MAX_SUBS + 1]));
+
+    // 缓存大小超过缓存块
+    MycoNode_t big;
+    setup_node(&big, "big", MN_CONF_CACHE_BLOCK_SIZE + 1, CONF_CACHED);
+    TEST_ASSERT_EQUAL_INT(MN_ERR_NOMEM, MycoNet_InitNode(&big));
+
+    TEST_ASSERT_EQUAL_INT(0, atomic_load(&g_heap_calls));
+}
+
+// ====================================================================
+// 主函数
+// ====================================================================
+int main(void) {
+    UNITY_BEGIN();
+
+    RUN_TEST(test_static_no_heap_after_init);
+    RUN_TEST(test_static_pool_exhaustion);
+
+    return UNITY_END();
+}
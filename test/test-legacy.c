@@ -0,0 +1,179 @@
+/**
+ * legacy C 核心的动态分配模式测试 (MN_CONF_STATIC_ALLOC=0)
+ *
+ *   make ctest-legacy && ./bin/ctest-legacy
+ *
+ * 主要覆盖写时复制的订阅者数组：发布过程中并发订阅、取消订阅和反初始化节点。
+ */
+#include "../3rd_party/unity/unity.h"
+#include "myconet.h"
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <string.h>
+
+// ====================================================================
+// 测试节点
+// ====================================================================
+#define SUB_NUM 4
+
+static MycoNode_t s_pub;
+static MycoNode_t s_subs[SUB_NUM];
+static atomic_int g_publish_count = 0;
+static atomic_int g_in_callback = 0;
+static atomic_bool g_running = false;
+
+static int count_cb(MycoNode_t *node_p, EventParam_t *param) {
+    (void)node_p;
+    if (param->event != EVENT_PUBLISH) return MN_OK;
+    atomic_fetch_add(&g_in_callback, 1);
+    atomic_fetch_add(&g_publish_count, 1);
+    sched_yield();
+    atomic_fetch_sub(&g_in_callback, 1);
+    return MN_OK;
+}
+
+static void setup_node(MycoNode_t *node_p, const char *name, uint32_t size,
+                       int (*cb)(MycoNode_t *, EventParam_t *)) {
+    memset(node_p, 0, sizeof(*node_p));
+    snprintf(node_p->name, sizeof(node_p->name), "%s", name);
+    node_p->size = size;
+    node_p->conflags = CONF_NONE;
+    node_p->event_msk = EVENT_PUBLISH;
+    node_p->event_cb = cb;
+    TEST_ASSERT_EQUAL_INT(MN_OK, MycoNet_InitNode(node_p));
+    TEST_ASSERT_EQUAL_INT(MN_OK, MycoNet_PushBackNode(node_p));
+}
+
+static void *publisher_thread(void *arg) {
+    (void)arg;
+    int value = 0;
+    while (atomic_load(&g_running)) {
+        MycoNet_NodePublish(&s_pub, &value, sizeof(value));
+        value++;
+    }
+    return NULL;
+}
+
+void setUp(void) {
+    atomic_store(&g_publish_count, 0);
+    atomic_store(&g_in_callback, 0);
+    TEST_ASSERT_EQUAL_INT(MN_OK, MycoNet_Init());
+    setup_node(&s_pub, "pub", sizeof(int), count_cb);
+}
+
+void tearDown(void) {
+    for (int i = 0; i < SUB_NUM; i++) {
+        MycoNet_DeinitNode(&s_subs[i]);
+    }
+    MycoNet_DeinitNode(&s_pub);
+    MycoNet_Deinit();
+}
+
+// ====================================================================
+// 测试用例
+// ====================================================================
+void test_legacy_subscribe_while_publishing(void) {
+    char name[MN_NODE_NAME_MAX_LEN];
+    for (int i = 0; i < SUB_NUM; i++) {
+        snprintf(name, sizeof(name), "sub%d", i);
+        setup_node(&s_subs[i], name, 0, count_cb);
+    }
+
+    pthread_t tid;
+    atomic_store(&g_running, true);
+    TEST_ASSERT_EQUAL_INT(0, pthread_create(&tid, NULL, publisher_thread, NULL));
+
+    // 发布线程运行期间反复订阅、取消订阅
+    for (int round = 0; round < 2000; round++) {
+        MycoNode_t *sub = &s_subs[round % SUB_NUM];
+        TEST_ASSERT_EQUAL_INT(MN_OK, MycoNet_NodeSubscribe(sub, "pub"));
+        if (round % 3 == 0) sched_yield();
+        TEST_ASSERT_EQUAL_INT(MN_OK, MycoNet_NodeUnsubscribe(sub, "pub"));
+    }
+    for (int i = 0; i < SUB_NUM; i++) {
+        TEST_ASSERT_EQUAL_INT(MN_OK, MycoNet_NodeSubscribe(&s_subs[i], "pub"));
+    }
+    TEST_ASSERT_EQUAL_INT(SUB_NUM, MycoNet_GetNodePubNum(&s_pub));
+
+    atomic_store(&g_running, false);
+    pthread_join(tid, NULL);
+
+    // 订阅关系两侧保持一致
+    for (int i = 0; i < SUB_NUM; i++) {
+        TEST_ASSERT_EQUAL_INT(1, MycoNet_GetNodeSubNum(&s_subs[i]));
+        TEST_ASSERT_EQUAL_INT(MN_OK, MycoNet_NodeUnsubscribe(&s_subs[i], "pub"));
+        TEST_ASSERT_EQUAL_INT(MN_ERR_NOTFOUND, MycoNet_NodeUnsubscribe(&s_subs[i], "pub"));
+    }
+    TEST_ASSERT_EQUAL_INT(0, MycoNet_GetNodePubNum(&s_pub));
+
+    const int before = atomic_load(&g_publish_count);
+    int value = 0;
+    TEST_ASSERT_EQUAL_INT(MN_OK, MycoNet_NodePublish(&s_pub, &value, sizeof(value)));
+    TEST_ASSERT_EQUAL_INT(before, atomic_load(&g_publish_count));
+}
+
+void test_legacy_deinit_while_publishing(void) {
+    char name[MN_NODE_NAME_MAX_LEN];
+    pthread_t tid;
+
+    // 反初始化返回后，订阅者的回调不应再被调用
+    for (int round = 0; round < 200; round++) {
+        for (int i = 0; i < SUB_NUM; i++) {
+            snprintf(name, sizeof(name), "sub%d", i);
+            setup_node(&s_subs[i], name, 0, count_cb);
+            TEST_ASSERT_EQUAL_INT(MN_OK, MycoNet_NodeSubscribe(&s_subs[i], "pub"));
+        }
+        atomic_store(&g_running, true);
+        TEST_ASSERT_EQUAL_INT(0, pthread_create(&tid, NULL, publisher_thread, NULL));
+        sched_yield();
+
+        for (int i = 0; i < SUB_NUM; i++) {
+            TEST_ASSERT_EQUAL_INT(MN_OK, MycoNet_DeinitNode(&s_subs[i]));
+        }
+        TEST_ASSERT_EQUAL_INT(0, atomic_load(&g_in_callback));
+        TEST_ASSERT_EQUAL_INT(0, MycoNet_GetNodePubNum(&s_pub));
+        // 模拟节点内存被复用
+        memset(s_subs, 0xA5, sizeof(s_subs));
+        for (int i = 0; i < 100; i++) sched_yield();
+
+        atomic_store(&g_running, false);
+        pthread_join(tid, NULL);
+        memset(s_subs, 0, sizeof(s_subs));
+    }
+}
+
+static int deinit_self_cb(MycoNode_t *node_p, EventParam_t *param) {
+    (void)param;
+    atomic_fetch_add(&g_publish_count, 1);
+    return MycoNet_DeinitNode(node_p);
+}
+
+void test_legacy_deinit_from_callback(void) {
+    // 回调中反初始化自身不会等待自己持有的快照
+    setup_node(&s_subs[0], "sub0", 0, deinit_self_cb);
+    setup_node(&s_subs[1], "sub1", 0, count_cb);
+    TEST_ASSERT_EQUAL_INT(MN_OK, MycoNet_NodeSubscribe(&s_subs[0], "pub"));
+    TEST_ASSERT_EQUAL_INT(MN_OK, MycoNet_NodeSubscribe(&s_subs[1], "pub"));
+
+    int value = 1;
+    TEST_ASSERT_EQUAL_INT(MN_OK, MycoNet_NodePublish(&s_pub, &value, sizeof(value)));
+    TEST_ASSERT_EQUAL_INT(2, atomic_load(&g_publish_count));
+    TEST_ASSERT_EQUAL_INT(1, MycoNet_GetNodePubNum(&s_pub));
+    TEST_ASSERT_EQUAL_INT(MN_OK, MycoNet_NodePublish(&s_pub, &value, sizeof(value)));
+    TEST_ASSERT_EQUAL_INT(3, atomic_load(&g_publish_count));
+}
+
+// ====================================================================
+// 主函数
+// ====================================================================
+int main(void) {
+    UNITY_BEGIN();
+
+    RUN_TEST(test_legacy_subscribe_while_publishing);
+    RUN_TEST(test_legacy_deinit_while_publishing);
+    RUN_TEST(test_legacy_deinit_from_callback);
+
+    return UNITY_END();
+}
@@ -666,6 +666,207 @@ void test_pull_functionality(void) {
     myconet_remove_node_id(puller_id);
 }
 
+void test_pull_next_timeout(void) {
+    MycoNet_NodeParam_t cached_param = {
+        .size = sizeof(int),
+        .conflags = CONF_CACHED,
+        .event_msk = 0,
+        .event_cb = NULL,
+        .user_data = NULL
+    };
+
+    MycoNet_ID_t cached_node_id = 0;
+    int result = myconet_create_node(&cached_node_id, "pull_next_cached", &cached_param);
+    TEST_ASSERT_EQUAL_INT(MN_OK, result);
+
+    MycoNet_NodeParam_t puller_param = {0};
+    MycoNet_ID_t puller_id = 0;
+    result = myconet_create_node(&puller_id, "pull_next_puller", &puller_param);
+    TEST_ASSERT_EQUAL_INT(MN_OK, result);
+
+    // 尚无新数据，超时
+    int result_data = 0;
+    result = myconet_pull_next(puller_id, "pull_next_cached", &result_data, sizeof(result_data), 10);
+    TEST_ASSERT_EQUAL_INT(MN_ERR_TIMEOUT, result);
+
+    // 发布后立即可取
+    int data = 321;
+    myconet_publish(cached_node_id, &data, sizeof(data));
+    result = myconet_pull_next_id(puller_id, cached_node_id, &result_data, sizeof(result_data), 10);
+    TEST_ASSERT_EQUAL_INT(MN_INFO_CACHE_PULLED, result);
+    TEST_ASSERT_EQUAL_INT(321, result_data);
+
+    // 同一样本不会重复返回
+    result = myconet_pull_next_id(puller_id, cached_node_id, &result_data, sizeof(result_data), 0);
+    TEST_ASSERT_EQUAL_INT(MN_ERR_TIMEOUT, result);
+
+    myconet_remove_node_id(cached_node_id);
+    myconet_remove_node_id(puller_id);
+}
+
+// 应答服务回调：返回请求值的两倍
+void request_server_callback(const MycoNet_EventParam_t* param) {
+    if (param->event == EVENT_REQUEST) {
+        int answer = *(int*)param->data_p * 2;
+        myconet_reply(param->recver, param->corr_id, &answer, sizeof(answer));
+    }
+}
+
+void test_request_reply(void) {
+    MycoNet_NodeParam_t server_param = {
+        .size = 0,
+        .conflags = CONF_NONE,
+        .event_msk = EVENT_REQUEST,
+        .event_cb = request_server_callback,
+        .user_data = NULL
+    };
+    MycoNet_ID_t server_id = 0;
+    int result = myconet_create_node(&server_id, "request_server", &server_param);
+    TEST_ASSERT_EQUAL_INT(MN_OK, result);
+
+    MycoNet_NodeParam_t client_param = {0};
+    MycoNet_ID_t client_id = 0;
+    result = myconet_create_node(&client_id, "request_client", &client_param);
+    TEST_ASSERT_EQUAL_INT(MN_OK, result);
+
+    int req = 21, resp = 0;
+    result = myconet_request_wait(client_id, "request_server", &req, sizeof(req), &resp, sizeof(resp), 100);
+    TEST_ASSERT_EQUAL_INT(MN_OK, result);
+    TEST_ASSERT_EQUAL_INT(42, resp);
+
+    // 客户端不支持请求事件
+    result = myconet_request_wait(server_id, "request_client", &req, sizeof(req), &resp, sizeof(resp), 100);
+    TEST_ASSERT_EQUAL_INT(MN_ERR_NOSUPPORT, result);
+
+    myconet_remove_node_id(server_id);
+    myconet_remove_node_id(client_id);
+}
+
+void test_ctx_isolation(void) {
+    myconet_ctx_t *ctx_a = myconet_ctx_open("ctx_a");
+    myconet_ctx_t *ctx_b = myconet_ctx_open("ctx_b");
+    TEST_ASSERT_NOT_NULL(ctx_a);
+    TEST_ASSERT_NOT_NULL(ctx_b);
+
+    MycoNet_NodeParam_t cached_param = {
+        .size = sizeof(int),
+        .conflags = CONF_CACHED,
+        .event_msk = 0,
+        .event_cb = NULL,
+        .user_data = NULL
+    };
+    // 不同实例中可以存在同名节点
+    MycoNet_ID_t id_a = 0, id_b = 0;
+    TEST_ASSERT_EQUAL_INT(MN_OK, myconet_ctx_create_node(ctx_a, &id_a, "sensor", &cached_param));
+    TEST_ASSERT_EQUAL_INT(MN_OK, myconet_ctx_create_node(ctx_b, &id_b, "sensor", &cached_param));
+    TEST_ASSERT_EQUAL_INT(1, myconet_ctx_node_num(ctx_a));
+    TEST_ASSERT_EQUAL_INT(0, myconet_node_num());
+
+    int data_a = 1, data_b = 2, result_data = 0;
+    TEST_ASSERT_EQUAL_INT(MN_OK, myconet_ctx_publish(ctx_a, id_a, &data_a, sizeof(data_a)));
+    TEST_ASSERT_EQUAL_INT(MN_OK, myconet_ctx_publish(ctx_b, id_b, &data_b, sizeof(data_b)));
+    TEST_ASSERT_EQUAL_INT(MN_INFO_CACHE_PULLED, myconet_ctx_pull_anon(ctx_a, "sensor", &result_data, sizeof(result_data)));
+    TEST_ASSERT_EQUAL_INT(1, result_data);
+    TEST_ASSERT_EQUAL_INT(MN_INFO_CACHE_PULLED, myconet_ctx_pull_anon(ctx_b, "sensor", &result_data, sizeof(result_data)));
+    TEST_ASSERT_EQUAL_INT(2, result_data);
+    TEST_ASSERT_EQUAL_INT(MN_ERR_NOTFOUND, myconet_pull_anon("sensor", &result_data, sizeof(result_data)));
+
+    // 同名上下文指向同一实例
+    myconet_ctx_t *ctx_a2 = myconet_ctx_open("ctx_a");
+    TEST_ASSERT_EQUAL_INT(1, myconet_ctx_node_num(ctx_a2));
+    myconet_ctx_close(ctx_a2);
+
+    myconet_ctx_deinit(ctx_a);
+    myconet_ctx_deinit(ctx_b);
+    myconet_ctx_close(ctx_a);
+    myconet_ctx_close(ctx_b);
+}
+
+void test_node_handle(void) {
+    MycoNet_NodeParam_t cached_param = {
+        .size = sizeof(int),
+        .conflags = CONF_CACHED,
+        .event_msk = 0,
+        .event_cb = NULL,
+        .user_data = NULL
+    };
+    MycoNet_ID_t pub_id = 0, reader_id = 0;
+    TEST_ASSERT_EQUAL_INT(MN_OK, myconet_create_node(&pub_id, "handle_pub", &cached_param));
+    MycoNet_NodeParam_t reader_param = {0};
+    TEST_ASSERT_EQUAL_INT(MN_OK, myconet_create_node(&reader_id, "handle_reader", &reader_param));
+
+    myconet_node_t *pub = myconet_node_open(pub_id);
+    myconet_node_t *reader = myconet_node_open(reader_id);
+    TEST_ASSERT_NOT_NULL(pub);
+    TEST_ASSERT_NOT_NULL(reader);
+    TEST_ASSERT_NULL(myconet_node_open(9999));
+    TEST_ASSERT_EQUAL_INT(pub_id, myconet_node_id(pub));
+
+    // 句柄与 ID 接口看到同一份缓存
+    int data = 77, result_data = 0;
+    TEST_ASSERT_EQUAL_INT(MN_OK, myconet_node_publish(pub, &data, sizeof(data)));
+    TEST_ASSERT_EQUAL_INT(MN_INFO_CACHE_PULLED, myconet_node_pull_id(reader, pub_id, &result_data, sizeof(result_data)));
+    TEST_ASSERT_EQUAL_INT(77, result_data);
+    TEST_ASSERT_EQUAL_INT(MN_INFO_CACHE_PULLED, myconet_pull(reader_id, "handle_pub", &result_data, sizeof(result_data)));
+
+    // 节点移除后句柄失效，但仍可安全关闭
+    myconet_remove_node_id(pub_id);
+    TEST_ASSERT_EQUAL_INT(MN_ERR_NOTFOUND, myconet_node_publish(pub, &data, sizeof(data)));
+    TEST_ASSERT_EQUAL_INT(MN_ERR_NOTFOUND, myconet_publish(pub_id, &data, sizeof(data)));
+    myconet_node_close(pub);
+    myconet_node_close(reader);
+
+    // 重新初始化后 ID 会复用，不能命中旧实例里缓存的节点
+    TEST_ASSERT_EQUAL_INT(0, myconet_pub_num(reader_id));
+    myconet_deinit();
+    myconet_init();
+    MycoNet_ID_t first_id = 0, second_id = 0;
+    TEST_ASSERT_EQUAL_INT(MN_OK, myconet_create_node(&first_id, "handle_a", &cached_param));
+    TEST_ASSERT_EQUAL_INT(MN_OK, myconet_create_node(&second_id, "handle_b", &cached_param));
+    TEST_ASSERT_EQUAL_INT(reader_id, second_id);
+    TEST_ASSERT_EQUAL_INT(MN_ERR_SIZE_MISMATCH, myconet_publish(second_id, &data, 2));
+}
+
+void test_node_handle_outlives_deinit(void) {
+    MycoNet_NodeParam_t cached_param = {
+        .size = sizeof(int),
+        .conflags = CONF_CACHED,
+        .event_msk = 0,
+        .event_cb = NULL,
+        .user_data = NULL
+    };
+    MycoNet_ID_t pub_id = 0;
+    TEST_ASSERT_EQUAL_INT(MN_OK, myconet_create_node(&pub_id, "handle_pub", &cached_param));
+    myconet_node_t *pub = myconet_node_open(pub_id);
+    TEST_ASSERT_NOT_NULL(pub);
+
+    // 句柄仍打开时释放默认实例：实例随句柄存活到关闭为止
+    myconet_deinit();
+    int data = 5, result_data = 0;
+    TEST_ASSERT_EQUAL_INT(pub_id, myconet_node_id(pub));
+    TEST_ASSERT_EQUAL_INT(MN_OK, myconet_node_publish(pub, &data, sizeof(data)));
+    TEST_ASSERT_EQUAL_INT(MN_INFO_CACHE_PULLED, myconet_node_pull_id(pub, pub_id, &result_data, sizeof(result_data)));
+    TEST_ASSERT_EQUAL_INT(5, result_data);
+    // 新的默认实例看不到旧实例的节点
+    TEST_ASSERT_EQUAL_INT(0, myconet_node_num());
+    myconet_node_close(pub);
+
+    // 上下文实例同样如此，释放并关闭上下文后句柄依然可用
+    myconet_ctx_t *ctx = myconet_ctx_open("handle_ctx");
+    TEST_ASSERT_NOT_NULL(ctx);
+    MycoNet_ID_t ctx_id = 0;
+    TEST_ASSERT_EQUAL_INT(MN_OK, myconet_ctx_create_node(ctx, &ctx_id, "handle_pub", &cached_param));
+    myconet_node_t *ctx_pub = myconet_ctx_node_open(ctx, ctx_id);
+    TEST_ASSERT_NOT_NULL(ctx_pub);
+    myconet_ctx_deinit(ctx);
+    myconet_ctx_close(ctx);
+    data = 6;
+    TEST_ASSERT_EQUAL_INT(MN_OK, myconet_node_publish(ctx_pub, &data, sizeof(data)));
+    TEST_ASSERT_EQUAL_INT(MN_INFO_CACHE_PULLED, myconet_node_pull_id(ctx_pub, ctx_id, &result_data, sizeof(result_data)));
+    TEST_ASSERT_EQUAL_INT(6, result_data);
+    myconet_node_close(ctx_pub);
+}
+
 // ====================================================================
 // 新增测试：节点存在性检查
 // ====================================================================
@@ -1560,6 +1761,11 @@ int main(void) {
 
     // 拉取功能测试
     RUN_TEST(test_pull_functionality);
+    RUN_TEST(test_pull_next_timeout);
+    RUN_TEST(test_request_reply);
+    RUN_TEST(test_ctx_isolation);
+    RUN_TEST(test_node_handle);
+    RUN_TEST(test_node_handle_outlives_deinit);
 
     // 新增测试函数
     RUN_TEST(test_node_existence_check);